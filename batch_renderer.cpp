@@ -0,0 +1,237 @@
+#pragma once
+
+#include "mandelbrot_renderer.cpp"
+#include "cycle_timer.cpp"
+#include "worker_pool.cpp"
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Many independent renders (thumbnails: different views, sizes and iteration budgets)
+// on one pool of threads. A cheap 4x4 probe estimates every job's cost, jobs are run
+// most expensive first (longest-processing-time order keeps the pool busy to the end),
+// and jobs big enough to hold up the tail are split into bands of rows that any
+// thread can take. Whole jobs render into a buffer owned by the thread, split jobs into
+// a pooled image; both are reused across jobs and batches, so a batch allocates only
+// while buffers grow.
+
+struct RenderJob {
+    int width = 0;
+    int height = 0;
+    int max_iterations = 0;
+    double x_min = 0.0, x_max = 0.0, y_min = 0.0, y_max = 0.0;
+};
+
+struct BatchRenderOptions {
+    int threads = 0;                // 0 = every hardware thread
+    bool order_by_cost = true;      // false: submission order
+    bool split_jobs = true;         // false: every job is one task
+    int band_rows = 16;             // rows per task of a split job
+};
+
+struct BatchRenderStats {
+    int threads = 0;
+    int jobs = 0;
+    int tasks = 0;
+    int split = 0;                  // jobs rendered as bands
+    double elapsed_ms = 0.0;        // estimate and render, as the caller waits for it
+    double estimate_ms = 0.0;
+    double jobs_per_second = 0.0;
+    double latency_p50_ms = 0.0;    // batch start to job completion
+    double latency_p95_ms = 0.0;
+    double latency_p99_ms = 0.0;
+    double latency_max_ms = 0.0;
+    double service_p99_ms = 0.0;    // first task of a job started to its last finished
+    double utilization = 0.0;       // busy thread time over threads x elapsed
+    long buffer_allocations = 0;
+};
+
+namespace batch_detail {
+
+// Nearest-rank percentile of sorted values
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+} // namespace batch_detail
+
+class BatchRenderer {
+private:
+    struct Task {
+        int job;
+        int first_row;
+        int rows;
+    };
+    
+    struct JobState {
+        double cost = 0.0;                  // estimated iterations
+        std::atomic<int> remaining{0};      // tasks not finished yet
+        std::atomic<uint64_t> started{0};   // ticks of the first task, 0 until then
+        uint64_t finished = 0;
+        int image = -1;                     // pooled image of a split job
+    };
+    
+    WorkerPool pool;                        // kept from batch to batch
+    std::vector<std::vector<int32_t>> thread_buffers;
+    std::vector<std::vector<int32_t>> image_pool;
+    std::vector<int> free_images;
+    std::mutex pool_mutex;
+    long allocations = 0;
+    
+    // Buffer of at least size values, counting the times it has to grow
+    void reserve(std::vector<int32_t>& buffer, size_t size) {
+        if (buffer.capacity() < size) {
+            buffer.reserve(size);
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            allocations++;
+        }
+        buffer.resize(size);
+    }
+    
+    int32_t* acquire_image(JobState& state, size_t size) {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        if (state.image < 0) {
+            if (free_images.empty()) {
+                image_pool.emplace_back();
+                free_images.push_back(static_cast<int>(image_pool.size()) - 1);
+            }
+            state.image = free_images.back();
+            free_images.pop_back();
+            std::vector<int32_t>& image = image_pool[state.image];
+            if (image.capacity() < size) {
+                image.reserve(size);
+                allocations++;
+            }
+            image.resize(size);
+        }
+        return image_pool[state.image].data();
+    }
+    
+    void release_image(JobState& state) {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        free_images.push_back(state.image);
+        state.image = -1;
+    }
+    
+    // Iterations summed over a 4x4 grid of the view, scaled to the job's pixels; every
+    // pixel also costs a few iterations' worth of setup
+    static double estimate_cost(const RenderJob& job) {
+        const int probe = 4;
+        MandelbrotRenderer renderer(probe, probe, job.max_iterations);
+        int32_t iterations[probe * probe];
+        renderer.render_tile(job.x_min, job.x_max, job.y_min, job.y_max, 0, 0, probe, probe, iterations);
+        double sum = 0.0;
+        for (int32_t n : iterations) sum += n + 4;
+        return sum / (probe * probe) * job.width * job.height;
+    }
+    
+public:
+    // Called once per job on the thread that finished it; iterations (height x width,
+    // row-major) are only valid during the call
+    using JobDone = std::function<void(int job, const RenderJob&, const int32_t* iterations)>;
+    
+    BatchRenderStats render(const std::vector<RenderJob>& jobs, const BatchRenderOptions& options, const JobDone& done) {
+        using namespace batch_detail;
+        CycleTimer& timer = CycleTimer::instance();
+        BatchRenderStats stats;
+        stats.jobs = static_cast<int>(jobs.size());
+        int threads = resolve_thread_count(options.threads);
+        stats.threads = threads;
+        if (static_cast<int>(thread_buffers.size()) < threads) thread_buffers.resize(threads);
+        long allocations_before = allocations;
+        std::vector<uint64_t> busy(threads, 0);
+        
+        uint64_t start = timer.start();
+        std::vector<JobState> state(jobs.size());
+        std::atomic<size_t> next(0);
+        double total_cost = 0.0;
+        if (options.order_by_cost || options.split_jobs) {
+            pool.run(threads, [&](int t) {
+                uint64_t begin = timer.start();
+                for (size_t j = next++; j < jobs.size(); j = next++) state[j].cost = estimate_cost(jobs[j]);
+                busy[t] += timer.stop() - begin;
+            });
+            for (const auto& s : state) total_cost += s.cost;
+        }
+        stats.estimate_ms = timer.elapsed_ms(start, timer.stop());
+        
+        std::vector<int> order(jobs.size());
+        for (size_t j = 0; j < order.size(); j++) order[j] = static_cast<int>(j);
+        if (options.order_by_cost) {
+            std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return state[a].cost > state[b].cost; });
+        }
+        
+        // A job worth more than 1/8 of one thread's share would keep a thread busy after the rest are done
+        std::vector<Task> tasks;
+        double split_above = total_cost / (threads * 8.0);
+        for (int j : order) {
+            int height = jobs[j].height;
+            bool split = options.split_jobs && threads > 1 && state[j].cost > split_above && height > options.band_rows;
+            int rows = split ? options.band_rows : height;
+            for (int row = 0; row < height; row += rows) tasks.push_back({j, row, std::min(rows, height - row)});
+            state[j].remaining = (height + rows - 1) / rows;
+            if (split) stats.split++;
+        }
+        stats.tasks = static_cast<int>(tasks.size());
+        
+        next = 0;
+        pool.run(threads, [&](int t) {
+            for (size_t i = next++; i < tasks.size(); i = next++) {
+                const Task& task = tasks[i];
+                const RenderJob& job = jobs[task.job];
+                JobState& js = state[task.job];
+                uint64_t begin = timer.start();
+                uint64_t unset = 0;
+                js.started.compare_exchange_strong(unset, begin);
+                
+                bool whole = task.rows == job.height;
+                size_t pixels = static_cast<size_t>(job.width) * job.height;
+                int32_t* image;
+                if (whole) {
+                    reserve(thread_buffers[t], pixels);
+                    image = thread_buffers[t].data();
+                } else {
+                    image = acquire_image(js, pixels);
+                }
+                MandelbrotRenderer renderer(job.width, job.height, job.max_iterations);
+                renderer.render_tile(job.x_min, job.x_max, job.y_min, job.y_max, 0, task.first_row, job.width, task.rows,
+                                     image + static_cast<size_t>(task.first_row) * job.width);
+                
+                // The last task of a job hands it over; the pooled image goes back after that
+                if (--js.remaining == 0) {
+                    if (done) done(task.job, job, image);
+                    if (!whole) release_image(js);
+                    js.finished = timer.stop();
+                }
+                busy[t] += timer.stop() - begin;
+            }
+        });
+        uint64_t end = timer.stop();
+        
+        stats.elapsed_ms = timer.elapsed_ms(start, end);
+        stats.jobs_per_second = stats.elapsed_ms > 0.0 ? jobs.size() / (stats.elapsed_ms / 1000.0) : 0.0;
+        std::vector<double> latency, service;
+        for (const auto& s : state) {
+            latency.push_back(timer.elapsed_ms(start, s.finished));
+            service.push_back(timer.elapsed_ms(s.started.load(), s.finished));
+        }
+        std::sort(latency.begin(), latency.end());
+        std::sort(service.begin(), service.end());
+        stats.latency_p50_ms = percentile(latency, 50.0);
+        stats.latency_p95_ms = percentile(latency, 95.0);
+        stats.latency_p99_ms = percentile(latency, 99.0);
+        stats.latency_max_ms = latency.empty() ? 0.0 : latency.back();
+        stats.service_p99_ms = percentile(service, 99.0);
+        double busy_ms = 0.0;
+        for (uint64_t ticks : busy) busy_ms += timer.ticks_to_ns(ticks) / 1e6;
+        stats.utilization = stats.elapsed_ms > 0.0 ? busy_ms / (threads * stats.elapsed_ms) : 0.0;
+        stats.buffer_allocations = allocations - allocations_before;
+        return stats;
+    }
+};
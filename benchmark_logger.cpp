@@ -1,8 +1,31 @@
+#include "host_fingerprint.cpp"
+#include "results_table.cpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
 #include <ctime>
-#include <cstdlib>
+#include <cmath>
+
+// One benchmark cell of a results row
+struct ResultColumn {
+    std::string name;       // column header, e.g. "WaveFront 400x400" or "Triad DRAM"
+    double value;           // NaN when the case produced no value
+    std::string unit;       // "ms", "GB/s", "ns"
+    std::string note;       // shown in parentheses after the value
+};
+
+// Composite score of the run; written with its rank among earlier rows scored
+// against the same reference
+struct RunScore {
+    double value = 0.0;     // 0 = not scored
+    double low = 0.0;       // 95% interval, unused when has_interval is false
+    double high = 0.0;
+    bool has_interval = false;
+    std::string reference;  // machine the score is relative to
+};
 
 class BenchmarkLogger {
 private:
@@ -20,222 +43,122 @@ private:
     }
     
     std::string get_system_info_compact() {
-        std::stringstream info;
-        
-        // Get OS info
-        #ifdef __APPLE__
-            std::system("sw_vers -productVersion > /tmp/os_info.txt 2>/dev/null");
-            std::ifstream os_file("/tmp/os_info.txt");
-            std::string os_version;
-            if (std::getline(os_file, os_version)) {
-                info << "macOS " << os_version;
-            } else {
-                info << "macOS";
-            }
-            os_file.close();
-            std::system("rm -f /tmp/os_info.txt");
-        #elif __linux__
-            info << "Linux";
-        #else
-            info << "Unknown";
-        #endif
-        
-        return info.str();
+        const HostFingerprint& host = get_host_fingerprint();
+        return host.os_name + " " + host.os_version;
     }
     
     std::string get_cpu_info_compact() {
-        std::stringstream info;
-        
-        #ifdef __APPLE__
-            std::system("sysctl -n machdep.cpu.brand_string > /tmp/cpu_info.txt 2>/dev/null");
-            std::ifstream cpu_file("/tmp/cpu_info.txt");
-            std::string cpu;
-            if (std::getline(cpu_file, cpu)) {
-                info << cpu;
-            } else {
-                info << "Unknown CPU";
-            }
-            cpu_file.close();
-            std::system("rm -f /tmp/cpu_info.txt");
-        #elif __linux__
-            std::system("grep 'model name' /proc/cpuinfo | head -1 | cut -d':' -f2 | sed 's/^ *//' > /tmp/cpu_info.txt 2>/dev/null");
-            std::ifstream cpu_file("/tmp/cpu_info.txt");
-            std::string cpu;
-            if (std::getline(cpu_file, cpu)) {
-                info << cpu;
-            } else {
-                info << "Unknown CPU";
-            }
-            cpu_file.close();
-            std::system("rm -f /tmp/cpu_info.txt");
-        #else
-            info << "Unknown CPU";
-        #endif
-        
-        return info.str();
+        return get_host_fingerprint().cpu_model;
     }
     
     std::string get_memory_info_compact() {
-        std::stringstream info;
-        
-        #ifdef __APPLE__
-            std::system("sysctl -n hw.memsize | awk '{print $1/1024/1024/1024 \" GB\"}' > /tmp/mem_info.txt 2>/dev/null");
-            std::ifstream mem_file("/tmp/mem_info.txt");
-            std::string mem;
-            if (std::getline(mem_file, mem)) {
-                info << mem;
-            } else {
-                info << "Unknown";
-            }
-            mem_file.close();
-            std::system("rm -f /tmp/mem_info.txt");
-        #elif __linux__
-            std::system("grep MemTotal /proc/meminfo | awk '{print $2/1024/1024 \" GB\"}' > /tmp/mem_info.txt 2>/dev/null");
-            std::ifstream mem_file("/tmp/mem_info.txt");
-            std::string mem;
-            if (std::getline(mem_file, mem)) {
-                info << mem;
-            } else {
-                info << "Unknown";
-            }
-            mem_file.close();
-            std::system("rm -f /tmp/mem_info.txt");
-        #else
-            info << "Unknown";
-        #endif
-        
-        return info.str();
+        return format_memory_gb(get_host_fingerprint().memory_total_kb);
     }
     
-    bool file_exists(const std::string& filename) {
-        std::ifstream file(filename);
-        return file.good();
+    static std::string score_cell(const RunScore& score) {
+        std::stringstream cell;
+        cell << std::fixed << std::setprecision(0) << score.value;
+        if (score.has_interval) cell << " (" << score.low << "-" << score.high << ")";
+        cell << " vs " << score.reference;
+        return cell.str();
     }
     
-    void create_header_if_needed() {
-        if (!file_exists(results_file)) {
-            std::ofstream file(results_file);
-            file << "# Benchmark Results\n\n";
-            file << "| Date | Machine | OS | CPU | Memory | Compiler | Mandelbrot Full | Mandelbrot Zoom1 | Mandelbrot Zoom2 | Mandelbrot Deep | WaveFront 50x50 | WaveFront 100x100 | WaveFront 200x200 | WaveFront 400x400 |\n";
-            file << "|------|---------|----|----|---------|----------|-----------------|------------------|------------------|-----------------|-----------------|-------------------|-------------------|-------------------|\n";
-            file.close();
+    // "N of M" among the rows whose score has the same reference, this run included
+    static std::string rank_cell(const ResultsTable& table, const RunScore& score) {
+        std::string suffix = " vs " + score.reference;
+        int rank = 1, total = 1;
+        for (const auto& cell : table.column("Score")) {
+            if (cell.size() < suffix.size() || cell.compare(cell.size() - suffix.size(), suffix.size(), suffix) != 0) continue;
+            try {
+                if (std::stod(cell) > score.value) rank++;
+                total++;
+            } catch (const std::exception&) {
+                // Not a score, e.g. "-" on rows from older runners
+            }
         }
+        return std::to_string(rank) + " of " + std::to_string(total);
     }
     
-    void force_recreate_with_header() {
-        std::ofstream file(results_file);
-        file << "# Benchmark Results\n\n";
-        file << "| Date | Machine | OS | CPU | Memory | Compiler | Mandelbrot Full | Mandelbrot Zoom1 | Mandelbrot Zoom2 | Mandelbrot Deep | WaveFront 50x50 | WaveFront 100x100 | WaveFront 200x200 | WaveFront 400x400 |\n";
-        file << "|------|---------|----|----|---------|----------|-----------------|------------------|------------------|-----------------|-----------------|-------------------|-------------------|-------------------|\n";
-        file.close();
+    bool file_exists(const std::string& filename) {
+        std::ifstream file(filename);
+        return file.good();
     }
     
 public:
     BenchmarkLogger(const std::string& filename = "benchmark_results.md") 
         : results_file(filename) {}
     
+    // Appends one row. Columns are matched by name, so files written with other sets
+    // of benchmark columns are migrated to the union of both.
     void log_results(const std::string& machine_name,
                     const std::string& compiler_flags,
-                    double mandelbrot_full, double mandelbrot_zoom1, 
-                    double mandelbrot_zoom2, double mandelbrot_deep,
-                    double wavefront_50, double wavefront_100,
-                    double wavefront_200, double wavefront_400) {
+                    const std::vector<ResultColumn>& results,
+                    const RunScore& score = RunScore()) {
         
         std::string temp_file = results_file + ".tmp";
         
         try {
-            // Step 1: Read and clean existing content
-            std::vector<std::string> valid_lines;
-            bool has_header = false;
-            bool has_separator = false;
-            
+            // Step 1: Read existing table; anything that is not part of it is dropped
+            ResultsTable table;
             if (file_exists(results_file)) {
                 std::ifstream read_file(results_file);
-                std::string line;
-                
-                while (std::getline(read_file, line)) {
-                    // Skip empty lines and garbage
-                    if (line.empty() || line.find("No newline") != std::string::npos) {
-                        continue;
-                    }
-                    
-                    // Keep title, header, separator, and data rows
-                    if (line.find("# Benchmark Results") == 0) {
-                        valid_lines.push_back(line);
-                    } else if (line.find("| Date |") == 0) {
-                        valid_lines.push_back(line);
-                        has_header = true;
-                    } else if (line.find("|------|") == 0) {
-                        valid_lines.push_back(line);
-                        has_separator = true;
-                    } else if (line.find("|") == 0 && line.find(" ms |") != std::string::npos) {
-                        // Data rows (start with | and contain " ms |")
-                        valid_lines.push_back(line);
-                    }
-                }
-                read_file.close();
+                std::stringstream content;
+                content << read_file.rdbuf();
+                table.parse(content.str());
             }
             
-            // Step 2: Ensure proper header structure
-            if (valid_lines.empty() || !has_header || !has_separator) {
-                valid_lines.clear();
-                valid_lines.push_back("# Benchmark Results");
-                valid_lines.push_back("");
-                valid_lines.push_back("| Date | Machine | OS | CPU | Memory | Compiler | Mandelbrot Full | Mandelbrot Zoom1 | Mandelbrot Zoom2 | Mandelbrot Deep | WaveFront 50x50 | WaveFront 100x100 | WaveFront 200x200 | WaveFront 400x400 |");
-                valid_lines.push_back("|------|---------|----|----|---------|----------|-----------------|------------------|------------------|-----------------|-----------------|-------------------|-------------------|-------------------|");
+            // Step 2: Create new data row
+            std::vector<std::pair<std::string, std::string>> cells = {
+                {"Date", get_current_datetime()},
+                {"Machine", machine_name},
+                {"OS", get_system_info_compact()},
+                {"CPU", get_cpu_info_compact()},
+                {"Memory", get_memory_info_compact()},
+                {"Compiler", compiler_flags}
+            };
+            for (const auto& result : results) {
+                // A case without a value (failed isolated run) still keeps the unit in its cell
+                std::stringstream cell;
+                if (std::isnan(result.value)) {
+                    cell << "- " << result.unit;
+                } else {
+                    cell << result.value << " " << result.unit;
+                }
+                if (!result.note.empty()) {
+                    cell << " (" << result.note << ")";
+                }
+                cells.push_back({result.name, cell.str()});
             }
+            if (score.value > 0.0) {
+                cells.push_back({"Score", score_cell(score)});
+                cells.push_back({"Rank", rank_cell(table, score)});
+            }
+            size_t rows_before = table.row_count();
+            table.add_row(cells);
             
-            // Step 3: Create new data row
-            std::stringstream new_row;
-            new_row << "| " << get_current_datetime()
-                    << " | " << machine_name
-                    << " | " << get_system_info_compact()
-                    << " | " << get_cpu_info_compact()
-                    << " | " << get_memory_info_compact()
-                    << " | " << compiler_flags
-                    << " | " << mandelbrot_full << " ms"
-                    << " | " << mandelbrot_zoom1 << " ms"
-                    << " | " << mandelbrot_zoom2 << " ms"
-                    << " | " << mandelbrot_deep << " ms"
-                    << " | " << wavefront_50 << " ms"
-                    << " | " << wavefront_100 << " ms"
-                    << " | " << wavefront_200 << " ms"
-                    << " | " << wavefront_400 << " ms"
-                    << " |";
-            
-            // Step 4: Write to temporary file
+            // Step 3: Write to temporary file
             std::ofstream temp_out(temp_file);
             if (!temp_out.is_open()) {
                 throw std::runtime_error("Cannot create temporary file");
             }
-            
-            for (const auto& line : valid_lines) {
-                temp_out << line << "\n";
-            }
-            temp_out << new_row.str() << "\n";
+            temp_out << table.str();
             temp_out.close();
             
-            // Step 5: Verify temporary file is valid
+            // Step 4: Verify temporary file is valid
             std::ifstream verify(temp_file);
             if (!verify.is_open()) {
                 throw std::runtime_error("Cannot verify temporary file");
             }
-            
-            // Count table rows (should be at least header + separator + 1 data row)
-            int table_rows = 0;
-            std::string verify_line;
-            while (std::getline(verify, verify_line)) {
-                if (verify_line.find("|") == 0) {
-                    table_rows++;
-                }
-            }
+            std::stringstream written;
+            written << verify.rdbuf();
             verify.close();
             
-            if (table_rows < 3) {
+            ResultsTable check;
+            if (!check.parse(written.str()) || check.row_count() != rows_before + 1) {
                 throw std::runtime_error("Temporary file validation failed");
             }
             
-            // Step 6: Replace original file with temporary file
+            // Step 5: Replace original file with temporary file
             if (std::rename(temp_file.c_str(), results_file.c_str()) != 0) {
                 throw std::runtime_error("Cannot replace original file");
             }
@@ -249,4 +172,4 @@ public:
             std::cout << "Original file preserved." << std::endl;
         }
     }
-};
\ No newline at end of file
+};
@@ -1,17 +1,31 @@
 #include "benchmark_logger.cpp"
+#include "cycle_timer.cpp"
+#include "memory_profiler.cpp"
+#include "trace_recorder.cpp"
+#include "sampling_profiler.cpp"
+#include "case_isolation.cpp"
 #include "gist_manager.cpp"
+#include "results_history.cpp"
+#include "regression_gate.cpp"
+#include "memory_benchmark.cpp"
+#include "machine_score.cpp"
+#include "kernel_dispatch.cpp"
 #include <iostream>
 #include <string>
 
 // Include benchmark classes
 #include <vector>
 #include <queue>
-#include <chrono>
 #include <thread>
 #include <complex>
 #include <cstdlib>
 #include <fstream>
 #include <sstream>
+#include <functional>
+#include <map>
+#include <iomanip>
+#include <memory>
+#include <atomic>
 
 // WaveFrontPlanner class (simplified for runner)
 class WaveFrontPlanner {
@@ -22,6 +36,7 @@ private:
     
 public:
     WaveFrontPlanner(int w, int h) : width(w), height(h) {
+        TRACE_SCOPE("grid construction");
         grid.resize(height, std::vector<int>(width, 0));
         distance.resize(height, std::vector<int>(width, -1));
         
@@ -36,48 +51,66 @@ public:
         }
     }
     
-    double planPath(int startX, int startY, int goalX, int goalY) {
-        auto start_time = std::chrono::high_resolution_clock::now();
+    // Milliseconds per plan; small grids repeat the plan passes times inside one
+    // timed region, so the sample is long enough to time reliably
+    HOT_KERNEL double planPath(int startX, int startY, int goalX, int goalY, int passes = 1) {
+        CycleTimer& timer = CycleTimer::instance();
+        uint64_t start_ticks = timer.start();
+        kernel_window_begin();
         
-        for (auto& row : distance) {
-            std::fill(row.begin(), row.end(), -1);
-        }
-        
-        std::queue<std::pair<int, int>> queue;
-        queue.push({goalY, goalX});
-        distance[goalY][goalX] = 0;
-        
-        int dx[] = {-1, 1, 0, 0};
-        int dy[] = {0, 0, -1, 1};
-        
-        while (!queue.empty()) {
-            auto [y, x] = queue.front();
-            queue.pop();
+        for (int pass = 0; pass < passes; pass++) {
+            {
+                TRACE_SCOPE("distance reset");
+                for (auto& row : distance) {
+                    std::fill(row.begin(), row.end(), -1);
+                }
+            }
             
-            for (int i = 0; i < 4; i++) {
-                int ny = y + dy[i];
-                int nx = x + dx[i];
+            {
+                TRACE_SCOPE("BFS");
+                std::queue<std::pair<int, int>> queue;
+                queue.push({goalY, goalX});
+                distance[goalY][goalX] = 0;
                 
-                if (nx >= 0 && nx < width && ny >= 0 && ny < height &&
-                    grid[ny][nx] == 0 && distance[ny][nx] == -1) {
-                    distance[ny][nx] = distance[y][x] + 1;
-                    queue.push({ny, nx});
+                int dx[] = {-1, 1, 0, 0};
+                int dy[] = {0, 0, -1, 1};
+                
+                while (!queue.empty()) {
+                    auto [y, x] = queue.front();
+                    queue.pop();
+                    
+                    for (int i = 0; i < 4; i++) {
+                        int ny = y + dy[i];
+                        int nx = x + dx[i];
+                        
+                        if (nx >= 0 && nx < width && ny >= 0 && ny < height &&
+                            grid[ny][nx] == 0 && distance[ny][nx] == -1) {
+                            distance[ny][nx] = distance[y][x] + 1;
+                            queue.push({ny, nx});
+                        }
+                    }
                 }
             }
         }
         
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
-        return duration.count() / 1000.0;
+        kernel_window_end();
+        uint64_t end_ticks = timer.stop();
+        return timer.elapsed_ms(start_ticks, end_ticks) / passes;
     }
 };
 
+// Plans per WaveFront sample: about as many cells as one 400x400 plan, which keeps
+// every sample above a millisecond
+int wavefront_passes(int width, int height) {
+    return std::max(1, 400 * 400 / (width * height));
+}
+
 // MandelbrotRenderer class (simplified for runner)
 class MandelbrotRenderer {
 private:
     int width, height, max_iterations;
     
-    int mandelbrot_iterations(std::complex<double> c) {
+    HOT_KERNEL int mandelbrot_iterations(std::complex<double> c) {
         std::complex<double> z = 0;
         for (int i = 0; i < max_iterations; i++) {
             if (std::abs(z) > 2.0) return i;
@@ -91,27 +124,239 @@ public:
         : width(w), height(h), max_iterations(max_iter) {}
     
     double render(double x_min, double x_max, double y_min, double y_max) {
-        auto start_time = std::chrono::high_resolution_clock::now();
+        TRACE_SCOPE("mandelbrot render");
+        CycleTimer& timer = CycleTimer::instance();
+        uint64_t start_ticks = timer.start();
+        kernel_window_begin();
         
         double x_scale = (x_max - x_min) / width;
         double y_scale = (y_max - y_min) / height;
         
+        long total_iterations = 0;
         for (int row = 0; row < height; row++) {
             double y = y_min + row * y_scale;
             for (int col = 0; col < width; col++) {
                 double x = x_min + col * x_scale;
                 std::complex<double> c(x, y);
-                mandelbrot_iterations(c);
+                total_iterations += mandelbrot_iterations(c);
+            }
+        }
+        
+        kernel_window_end();
+        uint64_t end_ticks = timer.stop();
+        keep_result(total_iterations);
+        return timer.elapsed_ms(start_ticks, end_ticks);
+    }
+    
+    // Same view with rows interleaved over threads
+    double render_parallel(double x_min, double x_max, double y_min, double y_max, int threads) {
+        TRACE_SCOPE("mandelbrot render parallel");
+        CycleTimer& timer = CycleTimer::instance();
+        uint64_t start_ticks = timer.start();
+        kernel_window_begin();
+        
+        double x_scale = (x_max - x_min) / width;
+        double y_scale = (y_max - y_min) / height;
+        std::atomic<long> total_iterations(0);
+        auto rows = [&](int first) {
+            long iterations = 0;
+            for (int row = first; row < height; row += threads) {
+                double y = y_min + row * y_scale;
+                for (int col = 0; col < width; col++) {
+                    iterations += mandelbrot_iterations(std::complex<double>(x_min + col * x_scale, y));
+                }
             }
+            total_iterations += iterations;
+        };
+        std::vector<std::thread> workers;
+        for (int t = 1; t < threads; t++) workers.emplace_back(rows, t);
+        rows(0);
+        for (auto& worker : workers) worker.join();
+        
+        kernel_window_end();
+        uint64_t end_ticks = timer.stop();
+        keep_result(total_iterations.load());
+        return timer.elapsed_ms(start_ticks, end_ticks);
+    }
+};
+
+struct RunnerOptions {
+    bool compare = false;
+    int repeats = 0;                  // 0 = default (1, or 5 in compare mode)
+    double regression_threshold = 5.0; // percent slowdown that fails the gate
+    double significance = 0.05;
+    int baseline_runs = 10;
+    std::string trace_file;           // empty = tracing off
+    int profile_hz = 0;               // 0 = sampling profiler off
+    std::string isolate;              // "", "on" (child per sample) or "both" (also in-process, side by side)
+    IsolationLimits limits;
+    std::string gist_endpoint;        // empty = GIST_API_URL or api.github.com
+    double sync_timeout = 30.0;       // seconds to wait for the result upload at exit
+    bool memory_report = false;       // full bandwidth matrix and latency curve before the cases
+    std::string reference;            // machine name or host id the score is relative to; empty = oldest in history
+    std::string reference_history;    // history file holding the reference runs; empty = benchmark_history.tsv
+};
+
+void print_usage() {
+    std::cout << "Usage: benchmark_runner [options]\n"
+              << "  --repeat=N          run every case N times and log the median\n"
+              << "  --compare           compare against earlier runs of this host and gate on regressions\n"
+              << "  --threshold=PCT     slowdown (percent) that fails the gate (default 5)\n"
+              << "  --alpha=P           significance level of the Mann-Whitney test (default 0.05)\n"
+              << "  --baseline-runs=N   number of earlier runs used as baseline (default 10)\n"
+              << "  --trace=FILE        record a Chrome/Perfetto timeline to FILE\n"
+              << "  --profile[=HZ]      sample each case (default 999 Hz) into profiles/<case>.folded\n"
+              << "  --isolate[=both]    run every sample in a forked child; 'both' also runs in-process for comparison\n"
+              << "  --timeout=SEC       wall-clock limit per isolated sample (default 120)\n"
+              << "  --mem-limit=MB      address-space limit per isolated sample\n"
+              << "  --cpu-limit=SEC     CPU-time limit per isolated sample\n"
+              << "  --prefault=MB       fault in MB of heap in the child before the case runs\n"
+              << "  --gist-endpoint=URL Gist API base URL (default $GIST_API_URL or https://api.github.com)\n"
+              << "  --sync-timeout=SEC  how long to wait for pending uploads before exiting (default 30)\n"
+              << "  --memory-report     print bandwidth per kernel and cache level and the latency curve first\n"
+              << "  --reference=NAME    score against this machine name or host id (default: oldest in the history)\n"
+              << "  --reference-history=FILE  history file with the reference machine's runs\n";
+}
+
+bool parse_options(int argc, char* argv[], RunnerOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string value;
+        size_t eq = arg.find('=');
+        if (eq != std::string::npos) {
+            value = arg.substr(eq + 1);
+            arg = arg.substr(0, eq);
         }
         
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
-        return duration.count() / 1000.0;
+        try {
+            if (arg == "--compare") {
+                options.compare = true;
+            } else if (arg == "--repeat") {
+                options.repeats = std::stoi(value);
+            } else if (arg == "--threshold") {
+                options.regression_threshold = std::stod(value);
+            } else if (arg == "--alpha") {
+                options.significance = std::stod(value);
+            } else if (arg == "--baseline-runs") {
+                options.baseline_runs = std::stoi(value);
+            } else if (arg == "--trace" && !value.empty()) {
+                options.trace_file = value;
+            } else if (arg == "--profile") {
+                options.profile_hz = value.empty() ? 999 : std::stoi(value);
+                if (options.profile_hz <= 0) throw std::invalid_argument(value);
+            } else if (arg == "--isolate") {
+                if (!value.empty() && value != "both") throw std::invalid_argument(value);
+                options.isolate = value.empty() ? "on" : value;
+            } else if (arg == "--timeout") {
+                options.limits.timeout_seconds = std::stod(value);
+            } else if (arg == "--mem-limit") {
+                options.limits.memory_limit_mb = std::stol(value);
+            } else if (arg == "--cpu-limit") {
+                options.limits.cpu_limit_seconds = std::stoi(value);
+            } else if (arg == "--prefault") {
+                options.limits.prefault_mb = std::stol(value);
+            } else if (arg == "--gist-endpoint" && !value.empty()) {
+                options.gist_endpoint = value;
+            } else if (arg == "--sync-timeout") {
+                options.sync_timeout = std::stod(value);
+            } else if (arg == "--memory-report") {
+                options.memory_report = true;
+            } else if (arg == "--reference" && !value.empty()) {
+                options.reference = value;
+            } else if (arg == "--reference-history" && !value.empty()) {
+                options.reference_history = value;
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            std::cout << "Invalid value for " << arg << ": '" << value << "'" << std::endl;
+            return false;
+        }
+    }
+    
+    if (options.repeats <= 0) {
+        options.repeats = options.compare ? 5 : 1;
+    }
+    return true;
+}
+
+// One column of the results table. run() returns the value in unit; the sample
+// records call it time_ms whatever the unit is.
+struct BenchmarkCase {
+    std::string name;
+    std::function<double()> run;
+    std::string unit = "ms";
+    std::string group = "compute";    // score group: "compute" or "memory"
+    bool threaded = false;            // counts towards the multi-thread score
+    
+    // Metric name in the history file; the regression gate reads its direction from it
+    std::string metric() const {
+        if (unit == "GB/s") return "bandwidth_gbs";
+        if (unit == "ns") return "latency_ns";
+        return "time_ms";
     }
 };
 
-int main() {
+// One measured execution of a case; runs in this process or inside an isolated child
+IsolatedRecord measure_sample(const BenchmarkCase& bench) {
+    FrequencyMonitor monitor;
+    monitor.begin(!bench.threaded); // the cycle counters see only this thread
+    MemoryScope memory;
+    double time_ms = bench.run();
+    MemoryReport usage = memory.finish();
+    FrequencyReport frequency = monitor.end();
+    
+    IsolatedRecord record;
+    record.time_ms = time_ms;
+    record.stable = frequency.stable ? 1 : 0;
+    record.effective_ghz = frequency.effective_ghz;
+    record.allocations = usage.allocations;
+    record.bytes_allocated = usage.bytes_allocated;
+    record.peak_rss_kb = usage.peak_rss_kb;
+    record.peak_is_scoped = usage.peak_is_scoped ? 1 : 0;
+    std::strncpy(record.reason, frequency.reason.c_str(), sizeof(record.reason) - 1);
+    return record;
+}
+
+std::vector<BenchmarkCase> build_cases() {
+    return {
+        {"Mandelbrot Full",   [] { MandelbrotRenderer r(200, 200, 100); return r.render(-2.5, 1.0, -1.25, 1.25); }},
+        {"Mandelbrot Zoom1",  [] { MandelbrotRenderer r(200, 200, 150); return r.render(-1.0, 0.0, -0.5, 0.5); }},
+        {"Mandelbrot Zoom2",  [] { MandelbrotRenderer r(200, 200, 200); return r.render(-0.75, -0.25, -0.25, 0.25); }},
+        {"Mandelbrot Deep",   [] { MandelbrotRenderer r(200, 200, 500); return r.render(-0.7463, -0.7453, 0.1102, 0.1112); }},
+        {"Mandelbrot MT",     [] {
+            MandelbrotRenderer r(400, 400, 200);
+            return r.render_parallel(-2.5, 1.0, -1.25, 1.25, std::max(1, get_host_fingerprint().logical_threads));
+        }, "ms", "compute", true},
+        {"WaveFront 50x50",   [] { WaveFrontPlanner p(50, 50); return p.planPath(1, 1, 48, 48, wavefront_passes(50, 50)); }},
+        {"WaveFront 100x100", [] { WaveFrontPlanner p(100, 100); return p.planPath(1, 1, 98, 98, wavefront_passes(100, 100)); }},
+        {"WaveFront 200x200", [] { WaveFrontPlanner p(200, 200); return p.planPath(1, 1, 198, 198, wavefront_passes(200, 200)); }},
+        {"WaveFront 400x400", [] { WaveFrontPlanner p(400, 400); return p.planPath(1, 1, 398, 398, wavefront_passes(400, 400)); }},
+        {"Triad L1",          [] { return stream_bandwidth(StreamKernel::Triad, working_set_bytes(MemoryLevel::L1), 1); }, "GB/s", "memory"},
+        {"Triad L2",          [] { return stream_bandwidth(StreamKernel::Triad, working_set_bytes(MemoryLevel::L2), 1); }, "GB/s", "memory"},
+        {"Triad LLC",         [] { return stream_bandwidth(StreamKernel::Triad, working_set_bytes(MemoryLevel::LLC), 1); }, "GB/s", "memory"},
+        {"Triad DRAM",        [] { return stream_bandwidth(StreamKernel::Triad, working_set_bytes(MemoryLevel::DRAM), 1); }, "GB/s", "memory"},
+        {"Triad DRAM MT",     [] {
+            int threads = std::max(1, get_host_fingerprint().logical_threads);
+            return stream_bandwidth(StreamKernel::Triad, working_set_bytes(MemoryLevel::DRAM) / threads, threads);
+        }, "GB/s", "memory", true},
+        {"Latency L1",        [] { return pointer_chase_latency(working_set_bytes(MemoryLevel::L1)); }, "ns", "memory"},
+        {"Latency LLC",       [] { return pointer_chase_latency(working_set_bytes(MemoryLevel::LLC)); }, "ns", "memory"},
+        {"Latency DRAM",      [] { return pointer_chase_latency(working_set_bytes(MemoryLevel::DRAM)); }, "ns", "memory"}
+    };
+}
+
+int main(int argc, char* argv[]) {
+    RunnerOptions options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 2;
+    }
+    
+    if (!options.trace_file.empty()) {
+        trace_enable(options.trace_file);
+    }
+    
     std::cout << "Automated Benchmark Runner" << std::endl;
     std::cout << "===========================" << std::endl;
     
@@ -129,75 +374,263 @@ int main() {
     std::getline(std::cin, github_token);
     
     // Setup Gist manager
-    GistManager gist_manager(gist_id, github_token);
+    GistManager gist_manager(gist_id, github_token, "benchmark_results.md", options.gist_endpoint);
+    gist_manager.set_worker_init(memory_exclude_this_thread);
     
     // Download existing results if Gist ID provided
     if (!gist_id.empty()) {
+        TRACE_SCOPE("gist download");
         gist_manager.download_existing_gist();
     }
     
-    std::cout << "\nRunning benchmarks..." << std::endl;
+    // Results left in the outbox by earlier runs are sent while the benchmarks run
+    if (gist_manager.pending_count() > 0) {
+        std::cout << gist_manager.pending_count() << " earlier result(s) pending in "
+                  << gist_manager.get_outbox_dir() << "/, syncing in the background" << std::endl;
+    }
+    gist_manager.start_sync();
     
-    // Run Mandelbrot benchmarks
-    std::cout << "Running Mandelbrot benchmarks..." << std::endl;
+    {
+        TRACE_SCOPE("system info probe");
+        get_host_fingerprint();
+    }
     
-    MandelbrotRenderer renderer1(200, 200, 100);
-    double mandelbrot_full = renderer1.render(-2.5, 1.0, -1.25, 1.25);
+    std::cout << "\nRunning benchmarks";
+    if (options.repeats > 1) {
+        std::cout << " (" << options.repeats << " repetitions each)";
+    }
+    std::cout << "..." << std::endl;
     
-    MandelbrotRenderer renderer2(200, 200, 150);
-    double mandelbrot_zoom1 = renderer2.render(-1.0, 0.0, -0.5, 0.5);
+    std::cout << "Timer: " << CycleTimer::instance().describe() << std::endl;
+    std::cout << "Build: " << build_flavor() << std::endl;
     
-    MandelbrotRenderer renderer3(200, 200, 200);
-    double mandelbrot_zoom2 = renderer3.render(-0.75, -0.25, -0.25, 0.25);
+    if (options.memory_report) {
+        TRACE_SCOPE("memory report");
+        print_memory_report(std::max(1, get_host_fingerprint().logical_threads));
+        std::cout << std::endl;
+    }
     
-    MandelbrotRenderer renderer4(200, 200, 500);
-    double mandelbrot_deep = renderer4.render(-0.7463, -0.7453, 0.1102, 0.1112);
+    std::vector<BenchmarkCase> cases = build_cases();
+    std::vector<std::vector<double>> samples(cases.size());
+    std::vector<double> medians(cases.size());
+    std::vector<bool> unstable(cases.size(), false);
+    std::vector<bool> process_peak(cases.size(), false); // peak RSS could not be reset for the case
+    std::vector<std::map<std::string, std::vector<double>>> memory_samples(cases.size());
+    std::vector<std::string> failures(cases.size());
+    std::vector<std::vector<double>> in_process_samples(cases.size());
     
-    // Run WaveFront benchmarks
-    std::cout << "Running WaveFront benchmarks..." << std::endl;
+    if (!options.isolate.empty()) {
+        std::cout << "Isolation: forked child per sample, timeout " << options.limits.timeout_seconds << " s";
+        if (options.limits.memory_limit_mb > 0) std::cout << ", memory " << options.limits.memory_limit_mb << " MB";
+        if (options.limits.cpu_limit_seconds > 0) std::cout << ", CPU " << options.limits.cpu_limit_seconds << " s";
+        if (options.limits.prefault_mb > 0) std::cout << ", prefault " << options.limits.prefault_mb << " MB";
+        std::cout << std::endl;
+    }
     
-    WaveFrontPlanner planner1(50, 50);
-    double wavefront_50 = planner1.planPath(1, 1, 48, 48);
+    std::unique_ptr<SamplingProfiler> profiler;
+    if (options.profile_hz > 0) {
+        profiler.reset(new SamplingProfiler(options.profile_hz));
+        std::cout << "Sampling profiler: " << options.profile_hz << " Hz (timings include its overhead)" << std::endl;
+        if (options.isolate == "on") {
+            std::cout << "  note: isolated children are not sampled, use --isolate=both to profile the in-process runs" << std::endl;
+        }
+    }
     
-    WaveFrontPlanner planner2(100, 100);
-    double wavefront_100 = planner2.planPath(1, 1, 98, 98);
+    for (size_t c = 0; c < cases.size(); c++) {
+        std::cout << "Running " << cases[c].name << "..." << std::endl;
+        const char* span_name = trace_intern("case " + cases[c].name);
+        std::vector<FrequencyReport> reports;
+        if (profiler) profiler->start();
+        for (int r = 0; r < options.repeats; r++) {
+            TRACE_SCOPE(span_name);
+            IsolatedRecord record;
+            if (options.isolate.empty()) {
+                record = measure_sample(cases[c]);
+            } else {
+                std::string error;
+                const BenchmarkCase& bench = cases[c];
+                if (!run_isolated([&bench] { return measure_sample(bench); }, options.limits, record, error)) {
+                    std::cout << "  sample " << (r + 1) << " failed: " << error << std::endl;
+                    failures[c] = error;
+                    continue;
+                }
+                if (options.isolate == "both") {
+                    in_process_samples[c].push_back(measure_sample(cases[c]).time_ms);
+                }
+            }
+            
+            samples[c].push_back(record.time_ms);
+            FrequencyReport frequency;
+            frequency.effective_ghz = record.effective_ghz;
+            frequency.stable = record.stable != 0;
+            frequency.reason = record.reason;
+            reports.push_back(frequency);
+            memory_samples[c]["allocs"].push_back(static_cast<double>(record.allocations));
+            memory_samples[c]["alloc_bytes"].push_back(static_cast<double>(record.bytes_allocated));
+            memory_samples[c]["peak_rss_kb"].push_back(static_cast<double>(record.peak_rss_kb));
+            if (!record.peak_is_scoped) process_peak[c] = true;
+        }
+        medians[c] = samples[c].empty() ? std::nan("") : sample_median(samples[c]);
+        
+        if (profiler) {
+            ProfileSummary profile = profiler->stop(cases[c].name);
+            std::cout << "  profile: " << profile.samples << " samples -> " << profile.output_file
+                      << " (overhead " << profile.overhead_percent << "%, "
+                      << (profile.samples > 0 ? profile.handler_ms * 1000.0 / profile.samples : 0.0) << " us/sample";
+            if (profile.dropped > 0) std::cout << ", " << profile.dropped << " dropped";
+            std::cout << ")" << std::endl;
+        }
+        
+        std::string reason;
+        if (!frequency_spread_stable(reports, reason)) {
+            unstable[c] = true;
+            std::cout << "  WARNING: unstable timing (" << reason << ")" << std::endl;
+        }
+    }
     
-    WaveFrontPlanner planner3(200, 200);
-    double wavefront_200 = planner3.planPath(1, 1, 198, 198);
+    if (options.isolate == "both") {
+        std::cout << "\nIn-process vs isolated (median ms):" << std::endl;
+        std::cout << std::left << std::setw(20) << "Case" << std::right << std::setw(14) << "In-process"
+                  << std::setw(14) << "Isolated" << std::setw(10) << "Delta" << std::endl;
+        for (size_t c = 0; c < cases.size(); c++) {
+            double shared = sample_median(in_process_samples[c]);
+            std::cout << std::left << std::setw(20) << cases[c].name << std::right << std::fixed << std::setprecision(3)
+                      << std::setw(14) << shared << std::setw(14) << medians[c];
+            if (shared > 0.0 && !std::isnan(medians[c])) {
+                std::cout << std::setw(9) << std::showpos << std::setprecision(1)
+                          << (medians[c] / shared - 1.0) * 100.0 << "%" << std::noshowpos;
+            }
+            std::cout << std::endl;
+            std::cout.unsetf(std::ios::fixed);
+            std::cout << std::setprecision(6);
+        }
+    }
     
-    WaveFrontPlanner planner4(400, 400);
-    double wavefront_400 = planner4.planPath(1, 1, 398, 398);
+    std::cout << "\nMemory per case (median of " << options.repeats << " run(s)):" << std::endl;
+    std::cout << std::left << std::setw(20) << "Case" << std::right << std::setw(14) << "Allocations"
+              << std::setw(16) << "Bytes" << std::setw(14) << "Peak RSS KB" << std::endl;
+    for (size_t c = 0; c < cases.size(); c++) {
+        std::cout << std::left << std::setw(20) << cases[c].name << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(14) << sample_median(memory_samples[c]["allocs"])
+                  << std::setw(16) << sample_median(memory_samples[c]["alloc_bytes"]);
+        if (process_peak[c]) {
+            std::cout << std::setw(14) << "(process)" << std::endl;
+        } else {
+            std::cout << std::setw(14) << sample_median(memory_samples[c]["peak_rss_kb"]) << std::endl;
+        }
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+    }
     
     // Get compiler flags
     #ifndef CXXFLAGS
     #define CXXFLAGS "Unknown"
     #endif
-    std::string compiler_flags = "g++ " + std::string(CXXFLAGS);
+    std::string compiler_flags = "g++ " + std::string(CXXFLAGS) + " (" + build_flavor() + ")";
+    // History key: runs of other flags or flavors are not this build's baseline (the ISA
+    // level is left out, so builds of one key compare across machines)
+    std::string build = std::string(CXXFLAGS) + " " + BUILD_FLAVOR;
     
-    // Log results
     BenchmarkLogger logger;
-    logger.log_results(machine_name, compiler_flags,
-                      mandelbrot_full, mandelbrot_zoom1, mandelbrot_zoom2, mandelbrot_deep,
-                      wavefront_50, wavefront_100, wavefront_200, wavefront_400);
+    std::string host = get_host_fingerprint().id;
+    ResultsHistory history;
+    history.load();
+    
+    // Compare against earlier runs before this run joins the history
+    int regressions = 0;
+    if (options.compare) {
+        std::cout << "\nRegression check against " << history.get_filename()
+                  << " (host " << host << ", build " << build << ", threshold " << options.regression_threshold << "%)" << std::endl;
+        RegressionGate gate(options.regression_threshold, options.significance, options.baseline_runs);
+        for (size_t c = 0; c < cases.size(); c++) {
+            if (samples[c].empty()) {
+                std::cout << std::left << std::setw(32) << cases[c].name << "failed (" << failures[c] << ")" << std::endl;
+                continue;
+            }
+            gate.evaluate(history, host, build, cases[c].name, cases[c].metric(), samples[c], !unstable[c]);
+            for (const auto& metric : memory_samples[c]) {
+                if (process_peak[c] && metric.first == "peak_rss_kb") {
+                    std::cout << std::left << std::setw(20) << cases[c].name << std::setw(15) << metric.first
+                              << "process-wide peak (not reset for the case, not gated)" << std::endl;
+                    continue;
+                }
+                gate.evaluate(history, host, build, cases[c].name, metric.first, metric.second);
+            }
+        }
+        regressions = gate.get_regressions();
+    }
+    
+    // Unstable samples and process-wide peaks are kept apart so they never become someone's baseline
+    for (size_t c = 0; c < cases.size(); c++) {
+        if (samples[c].empty()) continue;
+        history.append(host, machine_name, build, cases[c].name, cases[c].metric() + (unstable[c] ? "_unstable" : ""), samples[c]);
+        for (const auto& metric : memory_samples[c]) {
+            bool process_wide = process_peak[c] && metric.first == "peak_rss_kb";
+            history.append(host, machine_name, build, cases[c].name, metric.first + (process_wide ? "_process" : ""), metric.second);
+        }
+    }
+    
+    // Score against the reference machine, now that this run is in the history too
+    ResultsHistory reference_history(options.reference_history.empty() ? history.get_filename() : options.reference_history);
+    reference_history.load();
+    std::string reference_host = reference_history.find_host(options.reference, build);
+    RunScore run_score;
+    if (reference_host.empty()) {
+        std::cout << "\nNo reference machine '" << options.reference << "' with build '" << build << "' in "
+                  << reference_history.get_filename() << ", run not scored" << std::endl;
+    } else {
+        std::vector<ScoreInput> inputs;
+        for (size_t c = 0; c < cases.size(); c++) {
+            if (!unstable[c]) inputs.push_back({cases[c].name, cases[c].metric(), cases[c].group, cases[c].threaded, samples[c]});
+        }
+        MachineScore score = MachineScorer(reference_history, reference_host, build, options.baseline_runs).score(inputs);
+        print_machine_score(score);
+        if (score.composite.valid()) {
+            run_score = {score.composite.score, score.composite.low, score.composite.high, score.composite.has_interval,
+                         score.reference_machine.empty() ? reference_host : score.reference_machine};
+        }
+    }
+    
+    // Log results
+    std::vector<ResultColumn> results;
+    for (size_t c = 0; c < cases.size(); c++) {
+        std::string note;
+        if (samples[c].empty()) note = failures[c];
+        else if (unstable[c]) note = "unstable";
+        results.push_back({cases[c].name, medians[c], cases[c].unit, note});
+    }
+    logger.log_results(machine_name, compiler_flags, results, run_score);
     
     std::cout << "\nBenchmark completed!" << std::endl;
     std::cout << "Results saved to benchmark_results.md" << std::endl;
     
     // Upload to Gist
-    std::cout << "\nUploading results to GitHub Gist..." << std::endl;
-    if (gist_manager.upload_to_gist("Cross-Platform Benchmark Results")) {
+    std::cout << "\nUploading results to " << gist_manager.get_api_url() << "..." << std::endl;
+    size_t pending;
+    {
+        TRACE_SCOPE("gist upload");
+        gist_manager.queue_upload("Cross-Platform Benchmark Results");
+        pending = gist_manager.finish_sync(options.sync_timeout);
+    }
+    if (pending == 0) {
         std::cout << "Upload successful!" << std::endl;
-        if (gist_id.empty() && !gist_manager.get_gist_id().empty()) {
-            std::cout << "\n" << std::string(50, '=') << std::endl;
-            std::cout << "★ GIST ID FOR OTHER MACHINES: " << gist_manager.get_gist_id() << std::endl;
-            std::cout << "★ Copy this ID to use on other computers!" << std::endl;
-            std::cout << std::string(50, '=') << std::endl;
-        }
     } else {
-        std::cout << "Upload failed. Results are still saved locally." << std::endl;
+        std::cout << "Upload not finished: " << pending << " result(s) stay in " << gist_manager.get_outbox_dir()
+                  << "/ and are sent on the next run. Results are also saved locally." << std::endl;
+    }
+    // A new Gist may also come from an earlier run's pending results
+    if (gist_id.empty() && !gist_manager.get_gist_id().empty()) {
+        std::cout << "\n" << std::string(50, '=') << std::endl;
+        std::cout << "★ GIST ID FOR OTHER MACHINES: " << gist_manager.get_gist_id() << std::endl;
+        std::cout << "★ Copy this ID to use on other computers!" << std::endl;
+        std::cout << std::string(50, '=') << std::endl;
     }
     
-    gist_manager.cleanup_temp_files();
+    if (regressions > 0) {
+        std::cout << "\n" << regressions << " case(s) regressed beyond "
+                  << options.regression_threshold << "%" << std::endl;
+        return 1;
+    }
     
     return 0;
 }
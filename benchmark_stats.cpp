@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+// Small statistics helpers shared by the runner, the regression gate and the scoring layer.
+
+double sample_median(std::vector<double> samples) {
+    if (samples.empty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    size_t mid = samples.size() / 2;
+    if (samples.size() % 2 == 0) {
+        return (samples[mid - 1] + samples[mid]) / 2.0;
+    }
+    return samples[mid];
+}
+
+double sample_mean(const std::vector<double>& samples) {
+    if (samples.empty()) return 0.0;
+    return std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+}
+
+double sample_stddev(const std::vector<double>& samples) {
+    if (samples.size() < 2) return 0.0;
+    double mean = sample_mean(samples);
+    double sum_sq = 0.0;
+    for (double s : samples) {
+        sum_sq += (s - mean) * (s - mean);
+    }
+    return std::sqrt(sum_sq / (samples.size() - 1));
+}
+
+struct MannWhitneyResult {
+    double u;        // U statistic of the first sample
+    double z;        // normal approximation (continuity and tie corrected)
+    double p_value;  // two-sided
+};
+
+// Mann-Whitney U test using the normal approximation.
+// Needs roughly five samples per side before p can drop below 0.05.
+MannWhitneyResult mann_whitney_u(const std::vector<double>& a, const std::vector<double>& b) {
+    MannWhitneyResult result = {0.0, 0.0, 1.0};
+    size_t n1 = a.size(), n2 = b.size();
+    if (n1 == 0 || n2 == 0) return result;
+    
+    std::vector<std::pair<double, int>> pooled;
+    for (double v : a) pooled.push_back({v, 0});
+    for (double v : b) pooled.push_back({v, 1});
+    std::sort(pooled.begin(), pooled.end());
+    
+    // Average ranks over ties and accumulate the tie correction term
+    double rank_sum_a = 0.0;
+    double tie_term = 0.0;
+    size_t n = pooled.size();
+    for (size_t i = 0; i < n; ) {
+        size_t j = i;
+        while (j < n && pooled[j].first == pooled[i].first) j++;
+        double avg_rank = (i + 1 + j) / 2.0;
+        double t = static_cast<double>(j - i);
+        tie_term += t * t * t - t;
+        for (size_t k = i; k < j; k++) {
+            if (pooled[k].second == 0) rank_sum_a += avg_rank;
+        }
+        i = j;
+    }
+    
+    result.u = rank_sum_a - n1 * (n1 + 1) / 2.0;
+    double mean_u = n1 * n2 / 2.0;
+    double var_u = n1 * n2 / 12.0 * ((n + 1) - tie_term / (static_cast<double>(n) * (n - 1)));
+    if (var_u <= 0.0) return result;
+    
+    double diff = std::fabs(result.u - mean_u) - 0.5;
+    if (diff < 0.0) diff = 0.0;
+    result.z = (result.u > mean_u ? diff : -diff) / std::sqrt(var_u);
+    result.p_value = std::erfc(std::fabs(result.z) / std::sqrt(2.0));
+    return result;
+}
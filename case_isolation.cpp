@@ -0,0 +1,238 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <functional>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+#include <climits>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "cycle_timer.cpp"
+
+// Fixed-size record a forked child sends back over its pipe.
+// Both ends are the same binary, so native byte order and layout are fine;
+// magic and version catch truncated or foreign data.
+struct IsolatedRecord {
+    static const uint32_t expected_magic = 0x484e4342; // "BCNH"
+    static const uint16_t current_version = 2;
+    
+    uint32_t magic = expected_magic;
+    uint16_t version = current_version;
+    uint16_t stable = 1;
+    uint16_t peak_is_scoped = 0;    // 0: peak_rss_kb is the process's, not the case's
+    double time_ms = 0.0;
+    double effective_ghz = 0.0;
+    uint64_t allocations = 0;
+    uint64_t bytes_allocated = 0;
+    int64_t peak_rss_kb = 0;
+    char reason[96] = {0};
+};
+
+struct IsolationLimits {
+    long memory_limit_mb = 0;     // RLIMIT_AS, 0 = unlimited
+    int cpu_limit_seconds = 0;    // RLIMIT_CPU, 0 = unlimited
+    double timeout_seconds = 120; // wall clock, the child is killed after this
+    long prefault_mb = 0;         // heap touched and kept before the case runs
+};
+
+namespace isolation_detail {
+
+void apply_limits(const IsolationLimits& limits) {
+    if (limits.memory_limit_mb > 0) {
+        struct rlimit rl;
+        rl.rlim_cur = rl.rlim_max = static_cast<rlim_t>(limits.memory_limit_mb) * 1024 * 1024;
+        setrlimit(RLIMIT_AS, &rl);
+    }
+    if (limits.cpu_limit_seconds > 0) {
+        struct rlimit rl;
+        rl.rlim_cur = static_cast<rlim_t>(limits.cpu_limit_seconds);
+        rl.rlim_max = rl.rlim_cur + 1; // SIGXCPU first, SIGKILL a second later
+        setrlimit(RLIMIT_CPU, &rl);
+    }
+}
+
+#ifdef __GLIBC__
+// Bytes malloc holds in mmapped chunks rather than on the brk heap
+size_t mmapped_bytes() {
+    #if __GLIBC_PREREQ(2, 33)
+        return mallinfo2().hblkhd;
+    #else
+        return static_cast<size_t>(mallinfo().hblkhd);
+    #endif
+}
+#endif
+
+// Fault in heap pages up front and keep them in malloc's top chunk, so the case's
+// allocations reuse them instead of paying first-touch page faults. The blocks stay
+// under the mmap threshold so they come from the brk heap, and the trim threshold
+// stops free() from handing the heap back. Returns false with the reason otherwise.
+bool prefault_heap(long megabytes, std::string& error) {
+    if (megabytes <= 0) return true;
+    #ifdef __GLIBC__
+        // M_TRIM_THRESHOLD is an int and has to stay above the prefaulted size
+        if (megabytes > 1024) {
+            error = "at most 1024 MB can be prefaulted";
+            return false;
+        }
+        size_t bytes = static_cast<size_t>(megabytes) * 1024 * 1024;
+        const size_t block_bytes = 1024 * 1024;
+        if (mallopt(M_MMAP_THRESHOLD, static_cast<int>(4 * block_bytes)) == 0 ||
+            mallopt(M_TRIM_THRESHOLD, static_cast<int>(std::min<size_t>(bytes * 2, INT_MAX))) == 0) {
+            error = "mallopt rejected the thresholds";
+            return false;
+        }
+        
+        size_t mapped_before = mmapped_bytes();
+        std::vector<char*> blocks;
+        blocks.reserve(bytes / block_bytes);
+        long page = sysconf(_SC_PAGESIZE);
+        for (size_t done = 0; done < bytes; done += block_bytes) {
+            char* block = static_cast<char*>(std::malloc(block_bytes));
+            if (!block) break;
+            for (size_t i = 0; i < block_bytes; i += page) block[i] = 1;
+            blocks.push_back(block);
+        }
+        bool from_brk = mmapped_bytes() == mapped_before;
+        void* heap_end = sbrk(0);
+        for (char* block : blocks) std::free(block);
+        
+        if (blocks.size() * block_bytes < bytes) {
+            error = "out of memory after " + std::to_string(blocks.size()) + " MB";
+            return false;
+        }
+        if (!from_brk) {
+            error = "blocks did not come from the brk heap";
+            return false;
+        }
+        if (sbrk(0) != heap_end) {
+            error = "the heap was trimmed after the blocks were freed";
+            return false;
+        }
+        return true;
+    #else
+        error = "needs glibc's malloc";
+        return false;
+    #endif
+}
+
+bool read_full(int fd, void* buffer, size_t size, double timeout_seconds, bool& timed_out) {
+    char* out = static_cast<char*>(buffer);
+    size_t got = 0;
+    uint64_t deadline = monotonic_raw_ns() + static_cast<uint64_t>(timeout_seconds * 1e9);
+    timed_out = false;
+    while (got < size) {
+        uint64_t now = monotonic_raw_ns();
+        if (now >= deadline) {
+            timed_out = true;
+            return false;
+        }
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, static_cast<int>((deadline - now) / 1000000) + 1);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready == 0) continue;
+        ssize_t n = read(fd, out + got, size - got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false; // child exited early
+        got += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace isolation_detail
+
+// Runs body in a freshly forked child under the given limits and returns its record.
+// Returns false with a readable error on timeout, crash, limit hit or a malformed record.
+bool run_isolated(const std::function<IsolatedRecord()>& body, const IsolationLimits& limits,
+                  IsolatedRecord& record, std::string& error) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        error = std::string("pipe: ") + std::strerror(errno);
+        return false;
+    }
+    
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        error = std::string("fork: ") + std::strerror(errno);
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    
+    if (pid == 0) {
+        close(fds[0]);
+        isolation_detail::apply_limits(limits);
+        std::string prefault_error;
+        if (!isolation_detail::prefault_heap(limits.prefault_mb, prefault_error)) {
+            std::cerr << "prefault of " << limits.prefault_mb << " MB failed: " << prefault_error << std::endl;
+        }
+        int status = 0;
+        try {
+            IsolatedRecord result = body();
+            const char* p = reinterpret_cast<const char*>(&result);
+            size_t left = sizeof(result);
+            while (left > 0) {
+                ssize_t n = write(fds[1], p, left);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) {
+                    status = 2;
+                    break;
+                }
+                p += n;
+                left -= static_cast<size_t>(n);
+            }
+        } catch (const std::bad_alloc&) {
+            status = 3;
+        } catch (...) {
+            status = 4;
+        }
+        close(fds[1]);
+        _exit(status); // skip atexit handlers and static destructors of the parent's state
+    }
+    
+    close(fds[1]);
+    bool timed_out = false;
+    bool received = isolation_detail::read_full(fds[0], &record, sizeof(record), limits.timeout_seconds, timed_out);
+    close(fds[0]);
+    
+    if (timed_out) {
+        kill(pid, SIGKILL);
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    
+    if (timed_out) {
+        std::ostringstream text;
+        text << "timeout after " << limits.timeout_seconds << " s";
+        error = text.str();
+        return false;
+    }
+    if (WIFSIGNALED(status)) {
+        int sig = WTERMSIG(status);
+        error = sig == SIGXCPU ? "CPU limit exceeded" : std::string("killed by signal ") + strsignal(sig);
+        return false;
+    }
+    if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
+        error = WEXITSTATUS(status) == 3 ? "memory limit exceeded" : "child exited with status " + std::to_string(WEXITSTATUS(status));
+        return false;
+    }
+    if (!received || record.magic != IsolatedRecord::expected_magic || record.version != IsolatedRecord::current_version) {
+        error = "malformed result from child";
+        return false;
+    }
+    record.reason[sizeof(record.reason) - 1] = '\0';
+    return true;
+}
@@ -0,0 +1,373 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+uint64_t monotonic_raw_ns() {
+    struct timespec ts;
+    #ifdef CLOCK_MONOTONIC_RAW
+        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    #else
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+    #endif
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+// Interval timer used by every benchmark kernel.
+// Uses the invariant TSC when the CPU has one (calibrated against CLOCK_MONOTONIC_RAW),
+// otherwise CLOCK_MONOTONIC_RAW directly. The cost of a start/stop pair is measured
+// once and subtracted from every interval.
+class CycleTimer {
+private:
+    bool use_tsc;
+    double ticks_per_ns;
+    uint64_t overhead_ticks;
+    
+    static bool has_invariant_tsc() {
+        #if defined(__x86_64__) || defined(__i386__)
+            unsigned int eax, ebx, ecx, edx;
+            if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007) return false;
+            __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+            return (edx & (1u << 8)) != 0;
+        #else
+            return false;
+        #endif
+    }
+    
+    void calibrate() {
+        #if defined(__x86_64__) || defined(__i386__)
+            // Median of three 10 ms windows against the raw monotonic clock
+            double rates[3];
+            for (int attempt = 0; attempt < 3; attempt++) {
+                uint64_t tsc_begin = __rdtsc();
+                uint64_t ns_begin = monotonic_raw_ns();
+                while (monotonic_raw_ns() - ns_begin < 10000000ULL) {}
+                uint64_t tsc_end = __rdtsc();
+                uint64_t ns_end = monotonic_raw_ns();
+                rates[attempt] = static_cast<double>(tsc_end - tsc_begin) / (ns_end - ns_begin);
+            }
+            std::sort(rates, rates + 3);
+            ticks_per_ns = rates[1];
+        #endif
+    }
+    
+    void measure_overhead() {
+        uint64_t best = UINT64_MAX;
+        for (int i = 0; i < 1000; i++) {
+            uint64_t a = start();
+            uint64_t b = stop();
+            best = std::min(best, b - a);
+        }
+        overhead_ticks = best;
+    }
+    
+    CycleTimer() : use_tsc(false), ticks_per_ns(1.0), overhead_ticks(0) {
+        use_tsc = has_invariant_tsc();
+        if (use_tsc) calibrate();
+        if (ticks_per_ns <= 0.0) {
+            use_tsc = false;
+            ticks_per_ns = 1.0;
+        }
+        measure_overhead();
+    }
+    
+public:
+    static CycleTimer& instance() {
+        static CycleTimer timer;
+        return timer;
+    }
+    
+    // Serialized read at the start of an interval: earlier instructions retire first
+    uint64_t start() const {
+        #if defined(__x86_64__) || defined(__i386__)
+            if (use_tsc) {
+                _mm_lfence();
+                uint64_t t = __rdtsc();
+                _mm_lfence();
+                return t;
+            }
+        #endif
+        return monotonic_raw_ns();
+    }
+    
+    // rdtscp waits for the measured code; the fence keeps later code out of the interval
+    uint64_t stop() const {
+        #if defined(__x86_64__) || defined(__i386__)
+            if (use_tsc) {
+                unsigned int aux;
+                uint64_t t = __rdtscp(&aux);
+                _mm_lfence();
+                return t;
+            }
+        #endif
+        return monotonic_raw_ns();
+    }
+    
+    double elapsed_ns(uint64_t begin, uint64_t end) const {
+        uint64_t ticks = end - begin;
+        ticks = ticks > overhead_ticks ? ticks - overhead_ticks : 0;
+        return ticks / ticks_per_ns;
+    }
+    
+    double elapsed_ms(uint64_t begin, uint64_t end) const {
+        return elapsed_ns(begin, end) / 1e6;
+    }
+    
+    double ticks_to_ns(uint64_t ticks) const {
+        return ticks / ticks_per_ns;
+    }
+    
+    double get_overhead_ns() const {
+        return overhead_ticks / ticks_per_ns;
+    }
+    
+    bool is_tsc() const {
+        return use_tsc;
+    }
+    
+    std::string describe() const {
+        std::stringstream text;
+        if (use_tsc) {
+            text << "invariant TSC @ " << ticks_per_ns << " GHz";
+        } else {
+            text << "CLOCK_MONOTONIC_RAW";
+        }
+        text << ", overhead " << get_overhead_ns() << " ns";
+        return text.str();
+    }
+};
+
+// Thin wrapper over a per-thread perf_event hardware counter.
+// Unavailable (valid() == false) off Linux, in most containers or with a strict perf_event_paranoid.
+// count_kernel also counts in kernel mode where perf_event_paranoid allows it, user mode only otherwise.
+class PerfCounter {
+private:
+    int fd;
+    
+public:
+    PerfCounter(uint32_t type, uint64_t config, bool count_kernel = false) : fd(-1) {
+        #ifdef __linux__
+            struct perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.exclude_kernel = count_kernel ? 0 : 1;
+            attr.exclude_hv = 1;
+            fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fd < 0 && count_kernel) {
+                attr.exclude_kernel = 1;
+                fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+            }
+        #else
+            (void)type;
+            (void)config;
+            (void)count_kernel;
+        #endif
+    }
+    
+    ~PerfCounter() {
+        if (fd >= 0) close(fd);
+    }
+    
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+    
+    bool valid() const {
+        return fd >= 0;
+    }
+    
+    void start() {
+        #ifdef __linux__
+            if (fd < 0) return;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        #endif
+    }
+    
+    uint64_t stop() {
+        uint64_t value = 0;
+        #ifdef __linux__
+            if (fd < 0) return 0;
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &value, sizeof(value)) != sizeof(value)) value = 0;
+        #endif
+        return value;
+    }
+};
+
+struct FrequencyReport {
+    double effective_ghz = 0.0;   // core cycles per on-CPU ns inside the kernel windows, 0 when not counted
+    double start_mhz = 0.0;       // scaling_cur_freq around the region, 0 when not exposed
+    double end_mhz = 0.0;
+    bool stable = true;
+    std::string reason;
+};
+
+// Watches a timed region for frequency changes, throttling or a drifting TSC.
+// Sources, in order of preference: core cycles per on-CPU ns (task clock), scaling_cur_freq,
+// and TSC vs CLOCK_MONOTONIC_RAW agreement. Cycles are only counted inside kernel windows
+// (see kernel_window_begin), so set-up, allocation and page faults around the timed loop
+// do not pull the clock down. Both counters follow the calling thread only.
+class FrequencyMonitor {
+private:
+    PerfCounter cycles;
+    PerfCounter task_clock;
+    uint64_t core_cycles;
+    uint64_t on_cpu_ns;
+    uint64_t tsc_begin;
+    uint64_t ns_begin;
+    double mhz_begin;
+    int cpu;
+    
+    static double read_cur_freq_mhz(int cpu_index) {
+        if (cpu_index < 0) return 0.0;
+        std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu_index) + "/cpufreq/scaling_cur_freq");
+        double khz = 0.0;
+        if (!(file >> khz)) return 0.0;
+        return khz / 1000.0;
+    }
+    
+    static int current_cpu() {
+        #ifdef __linux__
+            return sched_getcpu();
+        #else
+            return -1;
+        #endif
+    }
+    
+public:
+    FrequencyMonitor()
+        #ifdef __linux__
+        : cycles(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, true),
+          task_clock(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, true),
+        #else
+        : cycles(0, 0), task_clock(0, 0),
+        #endif
+          core_cycles(0), on_cpu_ns(0), tsc_begin(0), ns_begin(0), mhz_begin(0.0), cpu(-1) {
+        CycleTimer::instance(); // calibrate now, not inside the first monitored region
+    }
+    
+    ~FrequencyMonitor() {
+        if (armed() == this) armed() = nullptr;
+    }
+    
+    FrequencyMonitor(const FrequencyMonitor&) = delete;
+    FrequencyMonitor& operator=(const FrequencyMonitor&) = delete;
+    
+    bool has_cycle_counter() const {
+        return cycles.valid() && task_clock.valid();
+    }
+    
+    // Monitor of this thread's current region, the one kernel windows report to
+    static FrequencyMonitor*& armed() {
+        static thread_local FrequencyMonitor* monitor = nullptr;
+        return monitor;
+    }
+    
+    // count_cycles = false leaves effective_ghz at 0, e.g. for threaded regions whose
+    // other threads the per-thread counters would miss
+    void begin(bool count_cycles = true) {
+        core_cycles = 0;
+        on_cpu_ns = 0;
+        armed() = count_cycles && has_cycle_counter() ? this : nullptr;
+        cpu = current_cpu();
+        mhz_begin = read_cur_freq_mhz(cpu);
+        ns_begin = monotonic_raw_ns();
+        tsc_begin = CycleTimer::instance().start();
+    }
+    
+    void window_begin() {
+        cycles.start();
+        task_clock.start();
+    }
+    
+    void window_end() {
+        core_cycles += cycles.stop();
+        on_cpu_ns += task_clock.stop();
+    }
+    
+    FrequencyReport end() {
+        if (armed() == this) armed() = nullptr;
+        uint64_t tsc_end = CycleTimer::instance().stop();
+        uint64_t ns_end = monotonic_raw_ns();
+        
+        FrequencyReport report;
+        CycleTimer& timer = CycleTimer::instance();
+        double tsc_ns = timer.elapsed_ns(tsc_begin, tsc_end);
+        double wall_ns = static_cast<double>(ns_end - ns_begin);
+        
+        if (on_cpu_ns > 0) {
+            report.effective_ghz = static_cast<double>(core_cycles) / on_cpu_ns;
+        }
+        
+        report.start_mhz = mhz_begin;
+        report.end_mhz = read_cur_freq_mhz(cpu);
+        if (report.start_mhz > 0.0 && report.end_mhz > 0.0 &&
+            std::fabs(report.end_mhz - report.start_mhz) > 0.1 * report.start_mhz) {
+            report.stable = false;
+            std::stringstream why;
+            why << "frequency changed " << report.start_mhz << " -> " << report.end_mhz << " MHz";
+            report.reason = why.str();
+        }
+        
+        if (timer.is_tsc() && wall_ns > 100000.0 && std::fabs(tsc_ns - wall_ns) > 0.01 * wall_ns + 50000.0) {
+            report.stable = false;
+            report.reason = "TSC disagrees with CLOCK_MONOTONIC_RAW";
+        }
+        return report;
+    }
+};
+
+// Timed kernels bracket their timed loop with these; no-ops unless this thread has a
+// FrequencyMonitor between begin() and end()
+void kernel_window_begin() {
+    if (FrequencyMonitor* monitor = FrequencyMonitor::armed()) monitor->window_begin();
+}
+
+void kernel_window_end() {
+    if (FrequencyMonitor* monitor = FrequencyMonitor::armed()) monitor->window_end();
+}
+
+// Across repeated samples of one case the effective clock should not move much;
+// a wide spread means throttling, turbo changes or the thread being descheduled.
+bool frequency_spread_stable(const std::vector<FrequencyReport>& reports, std::string& reason,
+                             double tolerance = 0.05) {
+    double lo = 0.0, hi = 0.0;
+    for (const auto& r : reports) {
+        if (!r.stable) {
+            reason = r.reason;
+            return false;
+        }
+        if (r.effective_ghz <= 0.0) continue;
+        if (lo == 0.0 || r.effective_ghz < lo) lo = r.effective_ghz;
+        if (r.effective_ghz > hi) hi = r.effective_ghz;
+    }
+    if (lo > 0.0 && (hi - lo) / hi > tolerance) {
+        std::stringstream why;
+        why << "effective clock varied " << lo << "-" << hi << " GHz";
+        reason = why.str();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,385 @@
+#pragma once
+
+#include "map_generators.cpp"
+#include "wavefront_planner.cpp"
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// On-disk goal distance fields, so a restarted planner can answer path queries for a
+// known map and goal without running the wavefront again. A file is a fixed header
+// followed by the payload:
+//   Raw16 / Raw32  one value per cell, row-major, mapped and read in place
+//   DeltaRle       run-length coded deltas between consecutive cells, decoded on load
+// Every value is stored as distance + 1, so 0 means unreachable (or occupied).
+// The header carries a hash of the occupancy grid the field was computed on, and a
+// checksum of the rest of the header and the payload.
+
+enum class DistanceEncoding : uint32_t {
+    Raw16 = 1,
+    Raw32 = 2,
+    DeltaRle = 3
+};
+
+const char* encoding_name(DistanceEncoding encoding) {
+    switch (encoding) {
+        case DistanceEncoding::Raw16: return "raw16";
+        case DistanceEncoding::Raw32: return "raw32";
+        case DistanceEncoding::DeltaRle: return "delta-rle";
+    }
+    return "unknown";
+}
+
+struct DistanceFieldHeader {
+    char magic[4] = {'W', 'F', 'D', 'F'};
+    uint32_t version = 0;       // set by save_distance_field
+    uint32_t width = 0;
+    uint32_t height = 0;
+    int32_t goal_x = 0;
+    int32_t goal_y = 0;
+    uint32_t connectivity = 4;
+    uint32_t encoding = 0;
+    uint64_t map_hash = 0;
+    uint64_t payload_bytes = 0;
+    uint64_t checksum = 0;
+};
+static_assert(sizeof(DistanceFieldHeader) == 56, "header layout is part of the file format");
+
+namespace field_detail {
+
+const uint32_t current_version = 2;
+
+// FNV-1a over 64-bit words, then the tail bytes; a word at a time keeps the check cheap
+uint64_t checksum(const uint8_t* data, size_t size, uint64_t hash = 1469598103934665603ULL) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash ^= word;
+        hash *= 1099511628211ULL;
+    }
+    for (; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Header fields before the checksum, then the payload, so a damaged header fails too
+uint64_t file_checksum(const DistanceFieldHeader& header, const uint8_t* payload, size_t size) {
+    uint64_t hash = checksum(reinterpret_cast<const uint8_t*>(&header), offsetof(DistanceFieldHeader, checksum));
+    return checksum(payload, size, hash);
+}
+
+void put_varint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+bool get_varint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = *p++;
+        v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// Pairs of (zigzag delta, run length); wavefront fields change by -1, 0 or +1 between
+// neighbours, so long rows collapse to a handful of pairs
+std::vector<uint8_t> encode_delta_rle(const std::vector<uint32_t>& values) {
+    std::vector<uint8_t> out;
+    uint32_t previous = 0;
+    size_t i = 0;
+    while (i < values.size()) {
+        int64_t delta = static_cast<int64_t>(values[i]) - previous;
+        size_t run = 1;
+        while (i + run < values.size() &&
+               static_cast<int64_t>(values[i + run]) - values[i + run - 1] == delta) run++;
+        put_varint(out, static_cast<uint64_t>((delta << 1) ^ (delta >> 63)));
+        put_varint(out, run);
+        previous = values[i + run - 1];
+        i += run;
+    }
+    return out;
+}
+
+bool decode_delta_rle(const uint8_t* p, const uint8_t* end, std::vector<uint32_t>& values) {
+    uint32_t current = 0;
+    size_t i = 0;
+    while (p < end) {
+        uint64_t zigzag, run;
+        if (!get_varint(p, end, zigzag) || !get_varint(p, end, run)) return false;
+        if (run > values.size() - i) return false;
+        int64_t delta = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+        for (uint64_t r = 0; r < run; r++) {
+            current = static_cast<uint32_t>(current + delta);
+            values[i++] = current;
+        }
+    }
+    return i == values.size();
+}
+
+} // namespace field_detail
+
+// Identifies the occupancy grid a field belongs to: dimensions plus every cell
+uint64_t occupancy_hash(const OccupancyGrid& grid) {
+    uint64_t hash = 1469598103934665603ULL; // FNV-1a
+    auto mix = [&](uint64_t v) {
+        hash ^= v;
+        hash *= 1099511628211ULL;
+    };
+    mix(grid.size());
+    mix(grid.empty() ? 0 : grid[0].size());
+    for (const auto& row : grid) {
+        for (int cell : row) mix(cell != 0);
+    }
+    return hash;
+}
+
+// Cache file name for a map and goal, e.g. fields/3f2a..._120_80.wfdf
+std::string distance_field_path(const std::string& dir, uint64_t map_hash, int goal_x, int goal_y) {
+    std::stringstream path;
+    path << dir << "/" << std::hex << map_hash << std::dec << "_" << goal_x << "_" << goal_y << ".wfdf";
+    return path.str();
+}
+
+// Writes the field of the planner's last planPath call; the file appears atomically
+bool save_distance_field(const std::string& path, const WaveFrontPlanner& planner, int goal_x, int goal_y,
+                         DistanceEncoding encoding, std::string& error) {
+    int width = planner.getWidth();
+    int height = planner.getHeight();
+    std::vector<uint32_t> values(static_cast<size_t>(width) * height);
+    uint32_t largest = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint32_t v = static_cast<uint32_t>(planner.getDistance(x, y) + 1);
+            values[static_cast<size_t>(y) * width + x] = v;
+            largest = std::max(largest, v);
+        }
+    }
+    if (encoding == DistanceEncoding::Raw16 && largest > 0xffff) {
+        error = "distances do not fit in 16 bits";
+        return false;
+    }
+    
+    std::vector<uint8_t> payload;
+    if (encoding == DistanceEncoding::Raw16) {
+        std::vector<uint16_t> narrow(values.begin(), values.end());
+        payload.resize(narrow.size() * sizeof(uint16_t));
+        std::memcpy(payload.data(), narrow.data(), payload.size());
+    } else if (encoding == DistanceEncoding::Raw32) {
+        payload.resize(values.size() * sizeof(uint32_t));
+        std::memcpy(payload.data(), values.data(), payload.size());
+    } else {
+        payload = field_detail::encode_delta_rle(values);
+    }
+    
+    DistanceFieldHeader header;
+    header.version = field_detail::current_version;
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    header.goal_x = goal_x;
+    header.goal_y = goal_y;
+    header.connectivity = static_cast<uint32_t>(planner.getConnectivity());
+    header.encoding = static_cast<uint32_t>(encoding);
+    header.map_hash = occupancy_hash(planner.getGrid());
+    header.payload_bytes = payload.size();
+    header.checksum = field_detail::file_checksum(header, payload.data(), payload.size());
+    
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            error = "cannot create " + temp;
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        if (!file) {
+            error = "write failed for " + temp;
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        error = "cannot replace " + path;
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// A stored field, read through mmap. Raw files are used in place, so opening costs
+// the header checks plus (optionally) one checksum pass over the payload.
+class MappedDistanceField {
+private:
+    DistanceFieldHeader header;
+    const uint8_t* mapping = nullptr;
+    size_t mapping_bytes = 0;
+    const uint16_t* values16 = nullptr;
+    const uint32_t* values32 = nullptr;
+    std::vector<uint32_t> decoded;          // DeltaRle only
+    
+    static constexpr int dx[8] = {-1, 1, 0, 0, -1, 1, -1, 1};
+    static constexpr int dy[8] = {0, 0, -1, 1, -1, -1, 1, 1};
+    
+    uint32_t stored(int x, int y) const {
+        size_t i = static_cast<size_t>(y) * header.width + x;
+        return values16 ? values16[i] : values32[i];
+    }
+    
+    bool fail(const std::string& message, std::string& error) {
+        error = message;
+        close();
+        return false;
+    }
+    
+public:
+    MappedDistanceField() = default;
+    MappedDistanceField(const MappedDistanceField&) = delete;
+    MappedDistanceField& operator=(const MappedDistanceField&) = delete;
+    
+    ~MappedDistanceField() {
+        close();
+    }
+    
+    // map is the grid the caller plans on; a field computed for any other map is rejected
+    bool open(const std::string& path, const OccupancyGrid& map, std::string& error, bool verify = true) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "cannot open " + path;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(DistanceFieldHeader)) {
+            ::close(fd);
+            error = path + " is too short";
+            return false;
+        }
+        mapping_bytes = static_cast<size_t>(st.st_size);
+        void* address = mmap(nullptr, mapping_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            mapping_bytes = 0;
+            error = "cannot map " + path;
+            return false;
+        }
+        mapping = static_cast<const uint8_t*>(address);
+        
+        std::memcpy(&header, mapping, sizeof(header));
+        if (std::memcmp(header.magic, "WFDF", 4) != 0) return fail(path + " is not a distance field", error);
+        if (header.version != field_detail::current_version) {
+            return fail(path + " has format version " + std::to_string(header.version), error);
+        }
+        if (header.map_hash != occupancy_hash(map)) return fail(path + " belongs to a different map", error);
+        if (header.payload_bytes != mapping_bytes - sizeof(header)) return fail(path + " is truncated", error);
+        
+        const uint8_t* payload = mapping + sizeof(header);
+        if (verify && field_detail::file_checksum(header, payload, header.payload_bytes) != header.checksum) {
+            return fail(path + " failed its checksum", error);
+        }
+        // Checked even without verify: these fields size the decode and index the field
+        size_t map_width = map.empty() ? 0 : map[0].size();
+        if (header.width != map_width || header.height != map.size()) {
+            return fail(path + " has a size other than the map's", error);
+        }
+        if (header.connectivity != 4 && header.connectivity != 8) return fail(path + " has a bad connectivity", error);
+        if (header.goal_x < 0 || header.goal_y < 0 || static_cast<uint32_t>(header.goal_x) >= header.width ||
+            static_cast<uint32_t>(header.goal_y) >= header.height) {
+            return fail(path + " has its goal outside the map", error);
+        }
+        
+        size_t cells = static_cast<size_t>(header.width) * header.height;
+        switch (static_cast<DistanceEncoding>(header.encoding)) {
+            case DistanceEncoding::Raw16:
+                if (header.payload_bytes != cells * sizeof(uint16_t)) return fail(path + " has the wrong size", error);
+                values16 = reinterpret_cast<const uint16_t*>(payload);
+                break;
+            case DistanceEncoding::Raw32:
+                if (header.payload_bytes != cells * sizeof(uint32_t)) return fail(path + " has the wrong size", error);
+                values32 = reinterpret_cast<const uint32_t*>(payload);
+                break;
+            case DistanceEncoding::DeltaRle:
+                decoded.resize(cells);
+                if (!field_detail::decode_delta_rle(payload, payload + header.payload_bytes, decoded)) {
+                    return fail(path + " has a corrupt payload", error);
+                }
+                values32 = decoded.data();
+                break;
+            default:
+                return fail(path + " has an unknown encoding", error);
+        }
+        return true;
+    }
+    
+    void close() {
+        if (mapping) munmap(const_cast<uint8_t*>(mapping), mapping_bytes);
+        mapping = nullptr;
+        mapping_bytes = 0;
+        values16 = nullptr;
+        values32 = nullptr;
+        decoded.clear();
+        decoded.shrink_to_fit();
+    }
+    
+    bool isOpen() const { return values16 || values32; }
+    int getWidth() const { return static_cast<int>(header.width); }
+    int getHeight() const { return static_cast<int>(header.height); }
+    int getGoalX() const { return header.goal_x; }
+    int getGoalY() const { return header.goal_y; }
+    size_t getFileBytes() const { return mapping_bytes; }
+    DistanceEncoding getEncoding() const { return static_cast<DistanceEncoding>(header.encoding); }
+    
+    // Same meaning as WaveFrontPlanner::getDistance: steps to the goal, -1 if unreachable
+    int getDistance(int x, int y) const {
+        return static_cast<int>(stored(x, y)) - 1;
+    }
+    
+    // Descends the field like WaveFrontPlanner::getPath. The occupancy grid is not needed:
+    // a free orthogonal neighbour of a reachable cell is always reachable, so the
+    // corner-cutting check can use the stored values alone.
+    std::vector<std::pair<int, int>> getPath(int startX, int startY) const {
+        std::vector<std::pair<int, int>> path;
+        if (getDistance(startX, startY) < 0) return path;
+        int width = getWidth();
+        int height = getHeight();
+        int x = startX, y = startY;
+        path.push_back({x, y});
+        while (getDistance(x, y) > 0) {
+            int current = getDistance(x, y);
+            bool moved = false;
+            for (int i = 0; i < static_cast<int>(header.connectivity) && !moved; i++) {
+                int nx = x + dx[i];
+                int ny = y + dy[i];
+                if (nx < 0 || nx >= width || ny < 0 || ny >= height) continue;
+                int d = getDistance(nx, ny);
+                if (d < 0 || d >= current) continue;
+                if (dx[i] != 0 && dy[i] != 0 && (getDistance(nx, y) < 0 || getDistance(x, ny) < 0)) continue;
+                x = nx;
+                y = ny;
+                path.push_back({x, y});
+                moved = true;
+            }
+            if (!moved) {
+                path.clear(); // inconsistent field
+                break;
+            }
+        }
+        return path;
+    }
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "map_generators.cpp"
+#include "worker_pool.cpp"
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+// Euclidean distance transform of an occupancy grid (Felzenszwalb & Huttenlocher,
+// "Distance Transforms of Sampled Functions"): two separable passes of the exact 1D
+// lower-envelope transform, first along every row, then along every column.
+// Rows and columns are independent, so each pass is split across threads.
+
+struct ClearanceMap {
+    int width = 0;
+    int height = 0;
+    std::vector<float> squared;     // squared distance (cells) to the nearest obstacle, row-major
+    
+    float clearance(int x, int y) const {
+        return std::sqrt(squared[static_cast<size_t>(y) * width + x]);
+    }
+};
+
+namespace edt_detail {
+
+const double far = 1e20;            // "no obstacle on this line"
+
+// 1D squared distance transform of f (length n) into d; v and z are scratch of n and n+1
+void transform_1d(const double* f, int n, double* d, int* v, double* z) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -far * 2;
+    z[1] = far;
+    for (int q = 1; q < n; q++) {
+        // Intersection of the parabola from q with the rightmost one of the envelope;
+        // f is finite (at most far), so s always stays above z[0]
+        double s = ((f[q] + static_cast<double>(q) * q) - (f[v[k]] + static_cast<double>(v[k]) * v[k])) / (2.0 * (q - v[k]));
+        while (s <= z[k]) {
+            k--;
+            s = ((f[q] + static_cast<double>(q) * q) - (f[v[k]] + static_cast<double>(v[k]) * v[k])) / (2.0 * (q - v[k]));
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = far;
+    }
+    k = 0;
+    for (int q = 0; q < n; q++) {
+        while (z[k + 1] < q) k++;
+        double diff = q - v[k];
+        d[q] = diff * diff + f[v[k]];
+    }
+}
+
+} // namespace edt_detail
+
+// threads <= 0 uses every hardware thread
+ClearanceMap euclidean_distance_transform(const OccupancyGrid& grid, int threads = 0) {
+    ClearanceMap map;
+    map.height = static_cast<int>(grid.size());
+    map.width = map.height ? static_cast<int>(grid[0].size()) : 0;
+    map.squared.assign(static_cast<size_t>(map.width) * map.height, 0.0f);
+    threads = resolve_thread_count(threads);
+    int width = map.width;
+    int height = map.height;
+    
+    // Row pass: 0 on obstacles, "far" elsewhere
+    std::vector<double> rows(static_cast<size_t>(width) * height);
+    split_rows(height, threads, [&](int, int begin, int end) {
+        std::vector<double> f(width), d(width), z(width + 1);
+        std::vector<int> v(width);
+        for (int y = begin; y < end; y++) {
+            for (int x = 0; x < width; x++) {
+                f[x] = grid[y][x] != 0 ? 0.0 : edt_detail::far;
+            }
+            edt_detail::transform_1d(f.data(), width, d.data(), v.data(), z.data());
+            std::copy(d.begin(), d.end(), rows.begin() + static_cast<size_t>(y) * width);
+        }
+    });
+    
+    // Column pass over the row results; columns are gathered into a contiguous buffer
+    split_rows(width, threads, [&](int, int begin, int end) {
+        std::vector<double> f(height), d(height), z(height + 1);
+        std::vector<int> v(height);
+        for (int x = begin; x < end; x++) {
+            for (int y = 0; y < height; y++) {
+                f[y] = rows[static_cast<size_t>(y) * width + x];
+            }
+            edt_detail::transform_1d(f.data(), height, d.data(), v.data(), z.data());
+            for (int y = 0; y < height; y++) {
+                map.squared[static_cast<size_t>(y) * width + x] = static_cast<float>(std::min(d[y], edt_detail::far));
+            }
+        }
+    });
+    return map;
+}
+
+// Configuration-space map for a disc robot: every cell whose centre lies within
+// radius (cells) of an obstacle centre becomes an obstacle
+OccupancyGrid inflate_obstacles(const ClearanceMap& clearance, double radius) {
+    OccupancyGrid inflated(clearance.height, std::vector<int>(clearance.width, 0));
+    float limit = static_cast<float>(radius * radius);
+    for (int y = 0; y < clearance.height; y++) {
+        const float* row = &clearance.squared[static_cast<size_t>(y) * clearance.width];
+        for (int x = 0; x < clearance.width; x++) {
+            inflated[y][x] = row[x] <= limit ? 1 : 0;
+        }
+    }
+    return inflated;
+}
+
+OccupancyGrid inflate_obstacles(const OccupancyGrid& grid, double radius, int threads = 0) {
+    return inflate_obstacles(euclidean_distance_transform(grid, threads), radius);
+}
+
+// Reference implementation: stamp a disc around every obstacle cell
+OccupancyGrid inflate_by_disk_stamping(const OccupancyGrid& grid, double radius) {
+    int height = static_cast<int>(grid.size());
+    int width = height ? static_cast<int>(grid[0].size()) : 0;
+    OccupancyGrid inflated(height, std::vector<int>(width, 0));
+    int r = static_cast<int>(std::floor(radius));
+    double limit = radius * radius;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (grid[y][x] == 0) continue;
+            for (int dy = -r; dy <= r; dy++) {
+                int ny = y + dy;
+                if (ny < 0 || ny >= height) continue;
+                for (int dx = -r; dx <= r; dx++) {
+                    int nx = x + dx;
+                    if (nx >= 0 && nx < width && dx * dx + dy * dy <= limit) inflated[ny][nx] = 1;
+                }
+            }
+        }
+    }
+    return inflated;
+}
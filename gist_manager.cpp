@@ -1,161 +1,390 @@
+#include "http_client.cpp"
+#include "json_writer.cpp"
+#include "results_table.cpp"
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <cstdlib>
 #include <sstream>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <random>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Results are queued in an on-disk outbox and sent by a background thread, so a run
+// never blocks on the network and nothing is lost when it is down. Pending entries
+// are batched into one request and retried with exponential backoff; entries that
+// are still pending at exit are sent by the next run. The uploader thread reports on
+// stderr, so its messages stay out of the run's own output.
 
 class GistManager {
 private:
     std::string gist_id;
     std::string github_token;
     std::string filename;
+    std::string api_url;
+    std::string outbox_dir;
+    HttpClient http;
+    
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stopping = false;
+    bool gave_up = false;       // permanent error, keep the outbox for a later run
+    int attempts = 0;
+    std::function<void()> worker_init;
+    
+    static std::string default_api_url() {
+        const char* env = std::getenv("GIST_API_URL");
+        return env && *env ? env : "https://api.github.com";
+    }
+    
+    std::vector<std::pair<std::string, std::string>> request_headers() const {
+        std::vector<std::pair<std::string, std::string>> headers = {
+            {"Accept", "application/vnd.github+json"},
+            {"Content-Type", "application/json"}
+        };
+        if (!github_token.empty()) {
+            headers.push_back({"Authorization", "token " + github_token});
+        }
+        return headers;
+    }
+    
+    // Union of the table rows of both files, in date order; columns are matched by name
+    static std::string merge_result_rows(const std::string& base, const std::string& extra) {
+        ResultsTable merged;
+        merged.parse(base);
+        ResultsTable other;
+        if (other.parse(extra)) merged.merge(other);
+        return merged.str();
+    }
+    
+    std::vector<std::string> pending_entries() const {
+        std::vector<std::string> entries;
+        DIR* dir = opendir(outbox_dir.c_str());
+        if (!dir) return entries;
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.size() > 5 && name.compare(name.size() - 5, 5, ".json") == 0) {
+                entries.push_back(outbox_dir + "/" + name);
+            }
+        }
+        closedir(dir);
+        std::sort(entries.begin(), entries.end()); // names start with a timestamp
+        return entries;
+    }
+    
+    static bool read_file(const std::string& path, std::string& content) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return false;
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        content = buffer.str();
+        return true;
+    }
+    
+    bool fetch_remote_content(std::string& content, std::string& error) {
+        HttpResponse response = http.request("GET", api_url + "/gists/" + gist_id, request_headers());
+        if (response.status != 200) {
+            error = response.error.empty() ? "HTTP " + std::to_string(response.status) : response.error;
+            return false;
+        }
+        if (!json_find_string(response.body, "content", content)) {
+            error = "response has no file content";
+            return false;
+        }
+        return true;
+    }
+    
+    // One create/update request; retryable is false for errors a retry cannot fix
+    bool send_content(const std::string& content, const std::string& description,
+                      std::string& error, bool& retryable) {
+        retryable = true;
+        std::string body = content;
+        if (!gist_id.empty()) {
+            if (github_token.empty()) {
+                error = "GitHub token required to update existing Gist";
+                retryable = false;
+                return false;
+            }
+            // Rows other machines added since this entry was queued must survive the update
+            std::string remote;
+            if (!fetch_remote_content(remote, error)) return false;
+            body = merge_result_rows(content, remote);
+        }
+        
+        JsonWriter payload;
+        payload.begin_object()
+            .key("description").value(description)
+            .key("public").value(true)
+            .key("files").begin_object()
+                .key(filename).begin_object()
+                    .key("content").value(body)
+                .end_object()
+            .end_object()
+        .end_object();
+        
+        std::string url = api_url + "/gists" + (gist_id.empty() ? "" : "/" + gist_id);
+        HttpResponse response = http.request(gist_id.empty() ? "POST" : "PATCH", url, request_headers(), payload.str());
+        if (response.status == 200 || response.status == 201) {
+            std::string html_url;
+            json_find_string(response.body, "html_url", html_url);
+            std::cerr << "Gist sync: uploaded to " << (html_url.empty() ? url : html_url) << std::endl;
+            
+            std::string new_id;
+            if (gist_id.empty() && json_find_string(response.body, "id", new_id) && !new_id.empty()) {
+                std::lock_guard<std::mutex> guard(lock);
+                gist_id = new_id; // the caller reports it with its summary
+            }
+            return true;
+        }
+        
+        if (response.status == 0) {
+            error = response.error;
+        } else {
+            std::string message;
+            json_find_string(response.body, "message", message);
+            error = "HTTP " + std::to_string(response.status) + (message.empty() ? "" : " " + message);
+            // Server errors, timeouts and rate limits are worth retrying, other client errors are not
+            retryable = response.status >= 500 || response.status == 408 || response.status == 429;
+        }
+        return false;
+    }
     
-    bool execute_command(const std::string& command) {
-        int result = std::system(command.c_str());
-        return result == 0;
+    // Sends everything in the outbox as one request: the newest snapshot merged with
+    // the rows of older entries. Entries are removed only once the server accepted them.
+    bool flush_outbox(std::string& error, bool& retryable) {
+        std::vector<std::string> entries = pending_entries();
+        if (entries.empty()) return true;
+        
+        std::string content;
+        std::string description = "Benchmark Results";
+        for (const auto& path : entries) {
+            std::string entry, entry_content, entry_description;
+            if (!read_file(path, entry) || !json_find_string(entry, "content", entry_content)) {
+                std::cerr << "Gist sync: discarding unreadable outbox entry " << path << std::endl;
+                std::remove(path.c_str());
+                continue;
+            }
+            content = content.empty() ? entry_content : merge_result_rows(entry_content, content);
+            if (json_find_string(entry, "description", entry_description)) description = entry_description;
+        }
+        if (content.empty()) return true;
+        
+        if (entries.size() > 1) {
+            std::cerr << "Gist sync: sending " << entries.size() << " pending results in one batch" << std::endl;
+        }
+        if (!send_content(content, description, error, retryable)) return false;
+        for (const auto& path : entries) {
+            std::remove(path.c_str());
+        }
+        return true;
+    }
+    
+    void worker_loop() {
+        if (worker_init) worker_init();
+        const double base_delay = 1.0;
+        const double max_delay = 60.0;
+        std::mt19937 rng(std::random_device{}());
+        double delay = base_delay;
+        
+        std::unique_lock<std::mutex> guard(lock);
+        while (!stopping) {
+            if (gave_up || pending_entries().empty()) {
+                wake.wait(guard);
+                continue;
+            }
+            
+            guard.unlock();
+            std::string error;
+            bool retryable = true;
+            bool sent = flush_outbox(error, retryable);
+            guard.lock();
+            attempts++;
+            
+            if (sent) {
+                delay = base_delay;
+                wake.notify_all();
+                continue;
+            }
+            if (!retryable) {
+                std::cerr << "Gist sync: " << error << ", results stay in " << outbox_dir << "/" << std::endl;
+                gave_up = true;
+                wake.notify_all();
+                continue;
+            }
+            
+            // Full jitter keeps several machines from retrying in lockstep
+            double wait = std::uniform_real_distribution<double>(0.5, 1.0)(rng) * delay;
+            std::cerr << "Gist sync: " << error << ", retrying in " << static_cast<int>(wait * 10) / 10.0 << " s" << std::endl;
+            wake.notify_all();
+            wake.wait_for(guard, std::chrono::duration<double>(wait), [this] { return stopping; });
+            delay = std::min(delay * 2, max_delay);
+        }
     }
     
 public:
-    GistManager(const std::string& id = "", const std::string& token = "", 
-                const std::string& file = "benchmark_results.md") 
-        : gist_id(id), github_token(token), filename(file) {}
+    GistManager(const std::string& id = "", const std::string& token = "",
+                const std::string& file = "benchmark_results.md",
+                const std::string& endpoint = "",
+                const std::string& outbox = "gist_outbox")
+        : gist_id(id), github_token(token), filename(file),
+          api_url(endpoint.empty() ? default_api_url() : endpoint), outbox_dir(outbox), http(10) {
+        while (!api_url.empty() && api_url.back() == '/') api_url.pop_back();
+    }
+    
+    ~GistManager() {
+        stop_sync();
+    }
+    
+    GistManager(const GistManager&) = delete;
+    GistManager& operator=(const GistManager&) = delete;
     
     void set_gist_id(const std::string& id) {
+        std::lock_guard<std::mutex> guard(lock);
         gist_id = id;
     }
     
     void set_github_token(const std::string& token) {
+        std::lock_guard<std::mutex> guard(lock);
         github_token = token;
     }
     
+    // Runs first thing on the uploader thread (e.g. to keep it out of allocation counters)
+    void set_worker_init(const std::function<void()>& init) {
+        worker_init = init;
+    }
+    
+    const std::string& get_api_url() const {
+        return api_url;
+    }
+    
     bool download_existing_gist() {
         if (gist_id.empty()) {
             std::cout << "No Gist ID provided, creating new local file." << std::endl;
             return false;
         }
         
-        std::string command = "curl -s https://api.github.com/gists/" + gist_id + 
-                             " | python3 -c \"import sys, json; data=json.load(sys.stdin); print(list(data['files'].values())[0]['content'])\" > " + filename;
-        
         std::cout << "Downloading existing Gist..." << std::endl;
-        if (execute_command(command)) {
-            // Check if file has content
-            std::ifstream file(filename);
-            if (file.good() && file.peek() != std::ifstream::traits_type::eof()) {
+        std::string content, error;
+        if (fetch_remote_content(content, error) && !content.empty()) {
+            std::ofstream file(filename, std::ios::binary);
+            file << content;
+            if (file.good()) {
                 std::cout << "Successfully downloaded existing results." << std::endl;
                 return true;
             }
         }
         
-        std::cout << "Could not download existing Gist or it was empty." << std::endl;
+        std::cout << "Could not download existing Gist or it was empty" << (error.empty() ? "." : " (" + error + ").") << std::endl;
         return false;
     }
     
+    // Synchronous single attempt, bypassing the outbox; not for use while the uploader runs
     bool upload_to_gist(const std::string& description = "Benchmark Results") {
-        if (!std::ifstream(filename).good()) {
+        std::string content;
+        if (!read_file(filename, content)) {
             std::cout << "Error: " << filename << " not found!" << std::endl;
             return false;
         }
-        
-        // Escape content for JSON
-        std::string temp_file = "/tmp/gist_content.txt";
-        std::string escape_command = "cat " + filename + " | sed 's/\"/\\\\\"/g' | sed 's/$/\\\\n/' | tr -d '\\n' > " + temp_file;
-        execute_command(escape_command);
-        
-        // Read escaped content
-        std::ifstream content_file(temp_file);
+        std::cout << "Uploading to GitHub Gist..." << std::endl;
+        std::string error;
+        bool retryable = true;
+        if (send_content(content, description, error, retryable)) return true;
+        std::cout << "Failed to upload to Gist: " << error << std::endl;
+        return false;
+    }
+    
+    // Snapshots the results file into the outbox and wakes the uploader
+    bool queue_upload(const std::string& description = "Benchmark Results") {
         std::string content;
-        std::getline(content_file, content);
-        content_file.close();
+        if (!read_file(filename, content)) {
+            std::cout << "Error: " << filename << " not found!" << std::endl;
+            return false;
+        }
+        mkdir(outbox_dir.c_str(), 0755);
         
-        // Create JSON payload
-        std::string json_payload = "{"
-            "\"description\":\"" + description + "\","
-            "\"public\":true,"
-            "\"files\":{"
-                "\"" + filename + "\":{"
-                    "\"content\":\"" + content + "\""
-                "}"
-            "}"
-        "}";
+        auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        char name[64];
+        std::snprintf(name, sizeof(name), "%015lld-%d.json", static_cast<long long>(now), static_cast<int>(getpid()));
+        std::string path = outbox_dir + "/" + name;
         
-        // Write JSON to temp file
-        std::string json_file = "/tmp/gist_payload.json";
-        std::ofstream payload_file(json_file);
-        payload_file << json_payload;
-        payload_file.close();
+        JsonWriter entry;
+        entry.begin_object()
+            .key("description").value(description)
+            .key("file").value(filename)
+            .key("content").value(content)
+        .end_object();
         
-        std::string command;
-        if (gist_id.empty()) {
-            // Create new Gist
-            if (github_token.empty()) {
-                // Anonymous Gist (no updates possible)
-                command = "curl -X POST -H \"Content-Type: application/json\" "
-                         "-d @" + json_file + " https://api.github.com/gists";
-            } else {
-                // Authenticated Gist
-                command = "curl -X POST -H \"Authorization: token " + github_token + "\" "
-                         "-H \"Content-Type: application/json\" "
-                         "-d @" + json_file + " https://api.github.com/gists";
-            }
-        } else {
-            // Update existing Gist
-            if (github_token.empty()) {
-                std::cout << "Error: GitHub token required to update existing Gist!" << std::endl;
+        // Written under a temporary name so the uploader never sees a partial entry
+        std::string temp_path = path + ".tmp";
+        {
+            std::ofstream out(temp_path, std::ios::binary);
+            out << entry.str();
+            if (!out.good()) {
+                std::cout << "Error: cannot write outbox entry " << temp_path << std::endl;
                 return false;
             }
-            command = "curl -X PATCH -H \"Authorization: token " + github_token + "\" "
-                     "-H \"Content-Type: application/json\" "
-                     "-d @" + json_file + " https://api.github.com/gists/" + gist_id;
         }
+        std::rename(temp_path.c_str(), path.c_str());
         
-        std::cout << "Uploading to GitHub Gist..." << std::endl;
-        std::string output_file = "/tmp/gist_response.json";
-        command += " > " + output_file + " 2>&1";
-        
-        if (execute_command(command)) {
-            // Parse response to get Gist URL
-            std::string extract_url = "grep '\"html_url\"' " + output_file + 
-                                    " | head -1 | sed 's/.*\"html_url\":\"//;s/\".*$//'";
-            std::string url_command = extract_url + " > /tmp/gist_url.txt";
-            execute_command(url_command);
-            
-            std::ifstream url_file("/tmp/gist_url.txt");
-            std::string url;
-            if (std::getline(url_file, url) && !url.empty()) {
-                std::cout << "Successfully uploaded to: " << url << std::endl;
-                
-                // If this was a new Gist, extract the ID for future updates
-                if (gist_id.empty()) {
-                    std::string extract_id = "grep '\"id\"' " + output_file + 
-                                           " | head -1 | sed 's/.*\"id\":\"//;s/\".*$//'";
-                    std::string id_command = extract_id + " > /tmp/gist_id.txt";
-                    execute_command(id_command);
-                    
-                    std::ifstream id_file("/tmp/gist_id.txt");
-                    std::string new_id;
-                    if (std::getline(id_file, new_id) && !new_id.empty()) {
-                        gist_id = new_id;
-                        std::cout << "\n" << std::string(50, '=') << std::endl;
-                        std::cout << "★ IMPORTANT: New Gist ID: " << gist_id << std::endl;
-                        std::cout << "★ Save this ID for future updates on other machines!" << std::endl;
-                        std::cout << std::string(50, '=') << std::endl;
-                    }
-                }
-                
-                return true;
-            }
+        std::lock_guard<std::mutex> guard(lock);
+        gave_up = false;
+        wake.notify_all();
+        return true;
+    }
+    
+    // Starts the background uploader; results left over from earlier runs go out right away
+    void start_sync() {
+        if (worker.joinable()) return;
+        stopping = false;
+        worker = std::thread(&GistManager::worker_loop, this);
+    }
+    
+    // Waits up to timeout_seconds for the outbox to drain, then stops the uploader.
+    // Returns the number of entries still pending.
+    size_t finish_sync(double timeout_seconds) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout_seconds);
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait_until(guard, deadline, [this] { return gave_up || pending_entries().empty(); });
         }
-        
-        std::cout << "Failed to upload to Gist. Check your internet connection and credentials." << std::endl;
-        return false;
+        stop_sync();
+        return pending_entries().size();
     }
     
-    void cleanup_temp_files() {
-        execute_command("rm -f /tmp/gist_content.txt /tmp/gist_payload.json /tmp/gist_response.json /tmp/gist_url.txt /tmp/gist_id.txt");
+    void stop_sync() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+            wake.notify_all();
+        }
+        if (worker.joinable()) worker.join();
     }
     
-    std::string get_gist_id() const {
+    size_t pending_count() const {
+        return pending_entries().size();
+    }
+    
+    int get_attempts() {
+        std::lock_guard<std::mutex> guard(lock);
+        return attempts;
+    }
+    
+    std::string get_gist_id() {
+        std::lock_guard<std::mutex> guard(lock);
         return gist_id;
     }
-};
\ No newline at end of file
+    
+    const std::string& get_outbox_dir() const {
+        return outbox_dir;
+    }
+};
@@ -0,0 +1,371 @@
+#pragma once
+
+#include "wavefront_planner.cpp"
+#include "map_generators.cpp"
+#include <vector>
+#include <queue>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <cstdlib>
+#include <climits>
+
+// HPA* (Botea, Mueller & Schaeffer, "Near Optimal Hierarchical Path-Finding") on top of
+// the WaveFront planner: the map is cut into square clusters, entrances are placed on
+// the free stretches of every cluster border, and entrance-to-entrance distances inside
+// a cluster come from WaveFrontPlanner runs on that cluster alone. Queries search the
+// small abstract graph and refine each abstract edge with one cluster-local wavefront.
+// Changing a cell only rebuilds the borders and clusters around it.
+
+struct HierarchicalPath {
+    int length = -1;                            // -1 when no path was found
+    std::vector<std::pair<int, int>> cells;     // filled by refine()
+    std::vector<int> waypoints;                 // abstract nodes between start and goal
+};
+
+class HierarchicalPlanner {
+private:
+    struct Edge {
+        int to;
+        int cost;
+    };
+    
+    struct Node {
+        int x, y;
+        int cluster;
+        bool alive = true;
+        int partner = -1;                       // node across the border, one step away
+        std::vector<Edge> intra;
+    };
+    
+    // Entrance nodes on both sides of the border east (or south) of a cluster
+    struct Border {
+        std::vector<int> near_nodes;
+        std::vector<int> far_nodes;
+    };
+    
+    OccupancyGrid grid;
+    int width, height;
+    int cluster_size;
+    int clusters_x, clusters_y;
+    std::vector<Node> nodes;
+    std::vector<int> free_nodes;
+    std::vector<Border> east_borders;
+    std::vector<Border> south_borders;
+    
+    int clusterOf(int x, int y) const {
+        return (y / cluster_size) * clusters_x + x / cluster_size;
+    }
+    
+    int newNode(int x, int y) {
+        int id;
+        if (!free_nodes.empty()) {
+            id = free_nodes.back();
+            free_nodes.pop_back();
+            nodes[id] = Node();
+        } else {
+            id = static_cast<int>(nodes.size());
+            nodes.push_back(Node());
+        }
+        nodes[id].x = x;
+        nodes[id].y = y;
+        nodes[id].cluster = clusterOf(x, y);
+        return id;
+    }
+    
+    void clearBorder(Border& border) {
+        for (int id : border.near_nodes) {
+            nodes[id].alive = false;
+            nodes[id].intra.clear();
+            free_nodes.push_back(id);
+        }
+        for (int id : border.far_nodes) {
+            nodes[id].alive = false;
+            nodes[id].intra.clear();
+            free_nodes.push_back(id);
+        }
+        border.near_nodes.clear();
+        border.far_nodes.clear();
+    }
+    
+    // Splits the border into maximal runs of cell pairs that are free on both sides;
+    // short runs get one entrance in the middle, long ones one at each end
+    void buildBorder(int cluster, bool east) {
+        Border& border = east ? east_borders[cluster] : south_borders[cluster];
+        clearBorder(border);
+        int cx = cluster % clusters_x;
+        int cy = cluster / clusters_x;
+        if (east && cx + 1 >= clusters_x) return;
+        if (!east && cy + 1 >= clusters_y) return;
+        
+        // Walk along the border: (x, y) on the near side, (x + sx, y + sy) on the far side
+        int length, x0, y0, ax, ay, sx, sy;
+        if (east) {
+            x0 = (cx + 1) * cluster_size - 1;
+            y0 = cy * cluster_size;
+            length = std::min(cluster_size, height - y0);
+            ax = 0; ay = 1; sx = 1; sy = 0;
+        } else {
+            x0 = cx * cluster_size;
+            y0 = (cy + 1) * cluster_size - 1;
+            length = std::min(cluster_size, width - x0);
+            ax = 1; ay = 0; sx = 0; sy = 1;
+        }
+        
+        auto add_entrance = [&](int i) {
+            int x = x0 + ax * i, y = y0 + ay * i;
+            int near = newNode(x, y);
+            int far = newNode(x + sx, y + sy);
+            nodes[near].partner = far;
+            nodes[far].partner = near;
+            border.near_nodes.push_back(near);
+            border.far_nodes.push_back(far);
+        };
+        
+        const int long_run = 6;
+        int run_start = -1;
+        for (int i = 0; i <= length; i++) {
+            bool open = false;
+            if (i < length) {
+                int x = x0 + ax * i, y = y0 + ay * i;
+                open = grid[y][x] == 0 && grid[y + sy][x + sx] == 0;
+            }
+            if (open && run_start < 0) run_start = i;
+            if (!open && run_start >= 0) {
+                int run_end = i - 1;
+                if (run_end - run_start + 1 >= long_run) {
+                    add_entrance(run_start);
+                    add_entrance(run_end);
+                } else {
+                    add_entrance((run_start + run_end) / 2);
+                }
+                run_start = -1;
+            }
+        }
+    }
+    
+    std::vector<int> clusterNodes(int cluster) const {
+        std::vector<int> ids;
+        int cx = cluster % clusters_x;
+        int cy = cluster / clusters_x;
+        const Border& east = east_borders[cluster];
+        const Border& south = south_borders[cluster];
+        ids.insert(ids.end(), east.near_nodes.begin(), east.near_nodes.end());
+        ids.insert(ids.end(), south.near_nodes.begin(), south.near_nodes.end());
+        if (cx > 0) {
+            const Border& west = east_borders[cluster - 1];
+            ids.insert(ids.end(), west.far_nodes.begin(), west.far_nodes.end());
+        }
+        if (cy > 0) {
+            const Border& north = south_borders[cluster - clusters_x];
+            ids.insert(ids.end(), north.far_nodes.begin(), north.far_nodes.end());
+        }
+        return ids;
+    }
+    
+    // A planner over just the cells of one cluster, so the wavefront cannot leave it
+    WaveFrontPlanner clusterPlanner(int cluster, int& origin_x, int& origin_y) const {
+        origin_x = (cluster % clusters_x) * cluster_size;
+        origin_y = (cluster / clusters_x) * cluster_size;
+        int w = std::min(cluster_size, width - origin_x);
+        int h = std::min(cluster_size, height - origin_y);
+        OccupancyGrid local(h, std::vector<int>(w));
+        for (int y = 0; y < h; y++) {
+            std::copy(grid[origin_y + y].begin() + origin_x, grid[origin_y + y].begin() + origin_x + w, local[y].begin());
+        }
+        return WaveFrontPlanner(local);
+    }
+    
+    void buildIntraEdges(int cluster) {
+        std::vector<int> ids = clusterNodes(cluster);
+        for (int id : ids) nodes[id].intra.clear();
+        if (ids.size() < 2) return;
+        
+        int ox, oy;
+        WaveFrontPlanner local = clusterPlanner(cluster, ox, oy);
+        for (size_t a = 0; a < ids.size(); a++) {
+            local.planPath(0, 0, nodes[ids[a]].x - ox, nodes[ids[a]].y - oy, false);
+            for (size_t b = 0; b < ids.size(); b++) {
+                if (a == b) continue;
+                int d = local.getDistance(nodes[ids[b]].x - ox, nodes[ids[b]].y - oy);
+                if (d >= 0) nodes[ids[a]].intra.push_back({ids[b], d});
+            }
+        }
+    }
+    
+    // Distances from (x, y) to the entrances of its cluster
+    std::vector<Edge> connect(int x, int y) const {
+        std::vector<Edge> edges;
+        int cluster = clusterOf(x, y);
+        int ox, oy;
+        WaveFrontPlanner local = clusterPlanner(cluster, ox, oy);
+        local.planPath(0, 0, x - ox, y - oy, false);
+        for (int id : clusterNodes(cluster)) {
+            int d = local.getDistance(nodes[id].x - ox, nodes[id].y - oy);
+            if (d >= 0) edges.push_back({id, d});
+        }
+        return edges;
+    }
+    
+public:
+    HierarchicalPlanner(const OccupancyGrid& occupancy, int cluster_side = 16)
+        : grid(occupancy), width(occupancy.empty() ? 0 : static_cast<int>(occupancy[0].size())),
+          height(static_cast<int>(occupancy.size())), cluster_size(cluster_side) {
+        clusters_x = (width + cluster_size - 1) / cluster_size;
+        clusters_y = (height + cluster_size - 1) / cluster_size;
+        east_borders.resize(clusters_x * clusters_y);
+        south_borders.resize(clusters_x * clusters_y);
+    }
+    
+    // Full preprocessing: every border, then every cluster
+    void build() {
+        nodes.clear();
+        free_nodes.clear();
+        for (auto& b : east_borders) b = Border();
+        for (auto& b : south_borders) b = Border();
+        for (int c = 0; c < clusters_x * clusters_y; c++) {
+            buildBorder(c, true);
+            buildBorder(c, false);
+        }
+        for (int c = 0; c < clusters_x * clusters_y; c++) {
+            buildIntraEdges(c);
+        }
+    }
+    
+    // Changes one cell and repairs the abstraction: the four borders of its cluster,
+    // then the intra edges of that cluster and of the neighbours sharing those borders
+    void setCell(int x, int y, int value) {
+        if (grid[y][x] == value) return;
+        grid[y][x] = value;
+        int cluster = clusterOf(x, y);
+        int cx = cluster % clusters_x;
+        int cy = cluster / clusters_x;
+        
+        buildBorder(cluster, true);
+        buildBorder(cluster, false);
+        if (cx > 0) buildBorder(cluster - 1, true);
+        if (cy > 0) buildBorder(cluster - clusters_x, false);
+        
+        buildIntraEdges(cluster);
+        if (cx > 0) buildIntraEdges(cluster - 1);
+        if (cx + 1 < clusters_x) buildIntraEdges(cluster + 1);
+        if (cy > 0) buildIntraEdges(cluster - clusters_x);
+        if (cy + 1 < clusters_y) buildIntraEdges(cluster + clusters_x);
+    }
+    
+    // A* over the abstract graph from start to goal; start and goal are linked
+    // to the entrances of their clusters first
+    HierarchicalPath findPath(int startX, int startY, int goalX, int goalY) const {
+        HierarchicalPath result;
+        if (grid[startY][startX] != 0 || grid[goalY][goalX] != 0) return result;
+        
+        std::vector<Edge> from_start = connect(startX, startY);
+        std::vector<Edge> to_goal = connect(goalX, goalY);
+        std::vector<int> goal_cost(nodes.size(), -1);
+        for (const Edge& e : to_goal) goal_cost[e.to] = e.cost;
+        
+        int best = INT_MAX;
+        int best_last = -1;
+        // Start and goal in one cluster may also be joined directly
+        if (clusterOf(startX, startY) == clusterOf(goalX, goalY)) {
+            int ox, oy;
+            WaveFrontPlanner local = clusterPlanner(clusterOf(goalX, goalY), ox, oy);
+            local.planPath(0, 0, goalX - ox, goalY - oy, false);
+            int d = local.getDistance(startX - ox, startY - oy);
+            if (d >= 0) best = d;
+        }
+        
+        auto heuristic = [&](int id) { return std::abs(nodes[id].x - goalX) + std::abs(nodes[id].y - goalY); };
+        std::vector<int> g(nodes.size(), INT_MAX);
+        std::vector<int> parent(nodes.size(), -1);
+        using Entry = std::pair<int, int>; // f, node
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+        for (const Edge& e : from_start) {
+            if (e.cost < g[e.to]) {
+                g[e.to] = e.cost;
+                open.push({e.cost + heuristic(e.to), e.to});
+            }
+        }
+        
+        while (!open.empty()) {
+            auto [f, id] = open.top();
+            open.pop();
+            if (f >= best) break;             // nothing left can beat the best complete path
+            if (f - heuristic(id) > g[id]) continue;
+            if (goal_cost[id] >= 0 && g[id] + goal_cost[id] < best) {
+                best = g[id] + goal_cost[id];
+                best_last = id;
+            }
+            auto relax = [&](int to, int cost) {
+                if (g[id] + cost < g[to]) {
+                    g[to] = g[id] + cost;
+                    parent[to] = id;
+                    open.push({g[to] + heuristic(to), to});
+                }
+            };
+            for (const Edge& e : nodes[id].intra) relax(e.to, e.cost);
+            if (nodes[id].partner >= 0) relax(nodes[id].partner, 1);
+        }
+        
+        if (best == INT_MAX) return result;
+        result.length = best;
+        for (int id = best_last; id >= 0; id = parent[id]) {
+            result.waypoints.push_back(id);
+        }
+        std::reverse(result.waypoints.begin(), result.waypoints.end());
+        return result;
+    }
+    
+    // Expands the waypoints of path into grid cells with one cluster-local wavefront
+    // per intra-cluster leg
+    void refine(int startX, int startY, int goalX, int goalY, HierarchicalPath& path) const {
+        path.cells.clear();
+        if (path.length < 0) return;
+        std::vector<std::pair<int, int>> points = {{startX, startY}};
+        for (int id : path.waypoints) points.push_back({nodes[id].x, nodes[id].y});
+        points.push_back({goalX, goalY});
+        
+        path.cells.push_back(points[0]);
+        for (size_t i = 1; i < points.size(); i++) {
+            auto [ax, ay] = points[i - 1];
+            auto [bx, by] = points[i];
+            if (ax == bx && ay == by) continue;
+            if (std::abs(ax - bx) + std::abs(ay - by) == 1 && clusterOf(ax, ay) != clusterOf(bx, by)) {
+                path.cells.push_back({bx, by}); // border crossing
+                continue;
+            }
+            int ox, oy;
+            WaveFrontPlanner local = clusterPlanner(clusterOf(bx, by), ox, oy);
+            local.planPath(0, 0, bx - ox, by - oy, false);
+            std::vector<std::pair<int, int>> leg = local.getPath(ax - ox, ay - oy);
+            for (size_t s = 1; s < leg.size(); s++) {
+                path.cells.push_back({leg[s].first + ox, leg[s].second + oy});
+            }
+        }
+    }
+    
+    int getNodeCount() const {
+        return static_cast<int>(nodes.size() - free_nodes.size());
+    }
+    
+    long getEdgeCount() const {
+        long edges = 0;
+        for (const Node& n : nodes) {
+            if (n.alive) edges += static_cast<long>(n.intra.size()) + (n.partner >= 0 ? 1 : 0);
+        }
+        return edges;
+    }
+    
+    // Bytes held by the abstract graph (the copy of the grid not included)
+    size_t getMemoryBytes() const {
+        size_t bytes = nodes.capacity() * sizeof(Node) + free_nodes.capacity() * sizeof(int);
+        for (const Node& n : nodes) bytes += n.intra.capacity() * sizeof(Edge);
+        for (const Border& b : east_borders) bytes += sizeof(Border) + (b.near_nodes.capacity() + b.far_nodes.capacity()) * sizeof(int);
+        for (const Border& b : south_borders) bytes += sizeof(Border) + (b.near_nodes.capacity() + b.far_nodes.capacity()) * sizeof(int);
+        return bytes;
+    }
+    
+    const OccupancyGrid& getGrid() const {
+        return grid;
+    }
+};
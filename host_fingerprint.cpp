@@ -0,0 +1,240 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <cstdlib>
+#include <thread>
+#include <sys/utsname.h>
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+
+// Everything we know about the machine a benchmark ran on.
+// Collected in-process from /proc, sysfs, uname() and sysctl, never by spawning shell pipelines.
+struct HostFingerprint {
+    std::string os_name;
+    std::string os_version;
+    std::string architecture;
+    std::string cpu_model;
+    int physical_cores = 0;
+    int logical_threads = 0;
+    long long l1d_cache_bytes = 0;
+    long long l1i_cache_bytes = 0;
+    long long l2_cache_bytes = 0;
+    long long l3_cache_bytes = 0;
+    long long memory_total_kb = 0;
+    int numa_nodes = 0;
+    std::string governor;   // CPU frequency governor, "unknown" if not exposed
+    std::string turbo;      // "enabled", "disabled" or "unknown"
+    std::string compiler;
+    std::string id;         // short hash of the hardware/OS fields, keys the results history
+};
+
+namespace host_detail {
+
+std::string read_first_line(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+// sysfs cache sizes look like "48K", "2048K" or "32M"
+long long parse_size(const std::string& text) {
+    if (text.empty()) return 0;
+    long long value = 0;
+    try {
+        value = std::stoll(text);
+    } catch (const std::exception&) {
+        return 0;
+    }
+    char unit = text.back();
+    if (unit == 'K') value *= 1024;
+    else if (unit == 'M') value *= 1024 * 1024;
+    else if (unit == 'G') value *= 1024LL * 1024 * 1024;
+    return value;
+}
+
+#ifdef __APPLE__
+std::string sysctl_string(const char* name) {
+    char buffer[256];
+    size_t size = sizeof(buffer);
+    if (sysctlbyname(name, buffer, &size, nullptr, 0) != 0) return "";
+    return std::string(buffer);
+}
+
+long long sysctl_number(const char* name) {
+    long long value = 0;
+    size_t size = sizeof(value);
+    if (sysctlbyname(name, &value, &size, nullptr, 0) != 0) return 0;
+    return value;
+}
+#endif
+
+void probe_linux(HostFingerprint& host) {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    std::set<std::pair<int, int>> cores;
+    int physical_id = 0;
+    while (std::getline(cpuinfo, line)) {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string key = trim(line.substr(0, colon));
+        std::string value = trim(line.substr(colon + 1));
+        
+        if (key == "processor") {
+            host.logical_threads++;
+        } else if (key == "model name" && host.cpu_model.empty()) {
+            host.cpu_model = value;
+        } else if (key == "physical id") {
+            physical_id = std::atoi(value.c_str());
+        } else if (key == "core id") {
+            cores.insert({physical_id, std::atoi(value.c_str())});
+        }
+    }
+    host.physical_cores = cores.empty() ? host.logical_threads : static_cast<int>(cores.size());
+    
+    std::ifstream meminfo("/proc/meminfo");
+    while (std::getline(meminfo, line)) {
+        if (line.find("MemTotal:") == 0) {
+            host.memory_total_kb = std::atoll(line.substr(9).c_str());
+            break;
+        }
+    }
+    
+    for (int index = 0; index < 8; index++) {
+        std::string base = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        std::string level = read_first_line(base + "level");
+        if (level.empty()) break;
+        std::string type = read_first_line(base + "type");
+        long long size = parse_size(read_first_line(base + "size"));
+        if (level == "1" && type == "Data") host.l1d_cache_bytes = size;
+        else if (level == "1" && type == "Instruction") host.l1i_cache_bytes = size;
+        else if (level == "2") host.l2_cache_bytes = size;
+        else if (level == "3") host.l3_cache_bytes = size;
+    }
+    
+    host.governor = read_first_line("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+    if (host.governor.empty()) host.governor = "unknown";
+    
+    std::string no_turbo = read_first_line("/sys/devices/system/cpu/intel_pstate/no_turbo");
+    std::string boost = read_first_line("/sys/devices/system/cpu/cpufreq/boost");
+    if (!no_turbo.empty()) host.turbo = no_turbo == "0" ? "enabled" : "disabled";
+    else if (!boost.empty()) host.turbo = boost == "1" ? "enabled" : "disabled";
+    else host.turbo = "unknown";
+    
+    for (int node = 0; node < 1024; node++) {
+        if (!std::ifstream("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist").good()) break;
+        host.numa_nodes++;
+    }
+    if (host.numa_nodes == 0) host.numa_nodes = 1;
+}
+
+HostFingerprint probe_host() {
+    HostFingerprint host;
+    
+    struct utsname uts;
+    if (uname(&uts) == 0) {
+        host.os_name = uts.sysname;
+        host.os_version = uts.release;
+        host.architecture = uts.machine;
+    }
+    
+    #ifdef __APPLE__
+        host.os_name = "macOS";
+        host.os_version = sysctl_string("kern.osproductversion");
+        host.cpu_model = sysctl_string("machdep.cpu.brand_string");
+        host.physical_cores = static_cast<int>(sysctl_number("hw.physicalcpu"));
+        host.logical_threads = static_cast<int>(sysctl_number("hw.logicalcpu"));
+        host.l1d_cache_bytes = sysctl_number("hw.l1dcachesize");
+        host.l1i_cache_bytes = sysctl_number("hw.l1icachesize");
+        host.l2_cache_bytes = sysctl_number("hw.l2cachesize");
+        host.l3_cache_bytes = sysctl_number("hw.l3cachesize");
+        host.memory_total_kb = sysctl_number("hw.memsize") / 1024;
+        host.numa_nodes = 1;
+        host.governor = "unknown";
+        host.turbo = "unknown";
+    #elif __linux__
+        probe_linux(host);
+    #endif
+    
+    if (host.os_name.empty()) host.os_name = "Unknown";
+    if (host.cpu_model.empty()) host.cpu_model = "Unknown CPU";
+    if (host.logical_threads == 0) host.logical_threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (host.physical_cores == 0) host.physical_cores = host.logical_threads;
+    
+    #if defined(__clang__)
+        host.compiler = std::string("clang ") + __clang_version__;
+    #elif defined(__GNUC__)
+        host.compiler = std::string("g++ ") + __VERSION__;
+    #else
+        host.compiler = "Unknown";
+    #endif
+    
+    // Hardware and OS identity only: compiler, flags, governor and turbo are what we compare across
+    std::stringstream key;
+    key << host.os_name << "|" << host.os_version << "|" << host.architecture << "|" << host.cpu_model
+        << "|" << host.physical_cores << "|" << host.logical_threads << "|" << host.l1d_cache_bytes
+        << "|" << host.l2_cache_bytes << "|" << host.l3_cache_bytes << "|" << host.memory_total_kb
+        << "|" << host.numa_nodes;
+    unsigned long long hash = 1469598103934665603ULL; // FNV-1a
+    for (unsigned char c : key.str()) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    std::stringstream id;
+    id << std::hex << hash;
+    host.id = id.str();
+    
+    return host;
+}
+
+} // namespace host_detail
+
+// Probed once, then cached for the lifetime of the process
+const HostFingerprint& get_host_fingerprint() {
+    static const HostFingerprint host = host_detail::probe_host();
+    return host;
+}
+
+std::string format_memory_gb(long long kb) {
+    std::stringstream text;
+    text << kb / 1024.0 / 1024.0 << " GB";
+    return text.str();
+}
+
+std::string format_cache_size(long long bytes) {
+    if (bytes <= 0) return "?";
+    if (bytes >= 1024 * 1024 && bytes % (1024 * 1024) == 0) return std::to_string(bytes / (1024 * 1024)) + "M";
+    return std::to_string(bytes / 1024) + "K";
+}
+
+// Multi-line summary printed by the standalone benchmarks
+std::string get_system_info() {
+    const HostFingerprint& host = get_host_fingerprint();
+    std::stringstream info;
+    info << "OS: " << host.os_name << " " << host.os_version << "\n";
+    info << "CPU: " << host.cpu_model << "\n";
+    info << "Cores: " << host.physical_cores << " cores / " << host.logical_threads << " threads, "
+         << host.numa_nodes << " NUMA node(s)\n";
+    info << "Caches: L1d " << format_cache_size(host.l1d_cache_bytes)
+         << ", L1i " << format_cache_size(host.l1i_cache_bytes)
+         << ", L2 " << format_cache_size(host.l2_cache_bytes)
+         << ", L3 " << format_cache_size(host.l3_cache_bytes) << "\n";
+    info << "Memory: " << format_memory_gb(host.memory_total_kb) << "\n";
+    info << "Frequency: governor " << host.governor << ", turbo " << host.turbo << "\n";
+    info << "Toolchain: " << host.compiler << "\n";
+    info << "Host ID: " << host.id << "\n";
+    return info.str();
+}
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+#include <unistd.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#ifdef HAVE_OPENSSL
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#endif
+
+// Small blocking HTTP/1.1 client: one request per connection, Content-Length or
+// chunked responses. https:// needs a build with -DHAVE_OPENSSL.
+
+struct HttpResponse {
+    int status = 0;          // 0 when no response was received
+    std::string body;
+    std::string error;       // transport-level failure
+};
+
+struct HttpUrl {
+    bool tls = false;
+    std::string host;
+    std::string port;
+    std::string path;
+};
+
+namespace http_detail {
+
+bool parse_url(const std::string& url, HttpUrl& out) {
+    size_t scheme_end = url.find("://");
+    if (scheme_end == std::string::npos) return false;
+    std::string scheme = url.substr(0, scheme_end);
+    if (scheme == "https") {
+        out.tls = true;
+    } else if (scheme != "http") {
+        return false;
+    }
+    
+    size_t host_begin = scheme_end + 3;
+    size_t path_begin = url.find('/', host_begin);
+    std::string authority = url.substr(host_begin, path_begin == std::string::npos ? std::string::npos : path_begin - host_begin);
+    out.path = path_begin == std::string::npos ? "/" : url.substr(path_begin);
+    
+    size_t colon = authority.rfind(':');
+    if (colon != std::string::npos && authority.find(']') == std::string::npos) {
+        out.host = authority.substr(0, colon);
+        out.port = authority.substr(colon + 1);
+    } else {
+        out.host = authority;
+        out.port = out.tls ? "443" : "80";
+    }
+    return !out.host.empty();
+}
+
+int connect_to(const std::string& host, const std::string& port, int timeout_ms, std::string& error) {
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    int rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+    if (rc != 0) {
+        error = "resolve " + host + ": " + gai_strerror(rc);
+        return -1;
+    }
+    
+    int fd = -1;
+    for (struct addrinfo* ai = result; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        rc = connect(fd, ai->ai_addr, ai->ai_addrlen);
+        if (rc != 0 && errno == EINPROGRESS) {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            int soerr = ETIMEDOUT;
+            if (poll(&pfd, 1, timeout_ms) == 1) {
+                socklen_t len = sizeof(soerr);
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &soerr, &len);
+            }
+            rc = soerr == 0 ? 0 : -1;
+            errno = soerr;
+        }
+        if (rc == 0) {
+            fcntl(fd, F_SETFL, flags);
+            struct timeval tv = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+            break;
+        }
+        error = "connect " + host + ":" + port + ": " + std::strerror(errno);
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+// Reassembles a chunked transfer-encoded body; trailers are ignored
+bool dechunk(const std::string& raw, std::string& body) {
+    body.clear();
+    size_t pos = 0;
+    while (pos < raw.size()) {
+        size_t line_end = raw.find("\r\n", pos);
+        if (line_end == std::string::npos) return false;
+        size_t size = std::strtoul(raw.substr(pos, line_end - pos).c_str(), nullptr, 16);
+        pos = line_end + 2;
+        if (size == 0) return true;
+        if (pos + size > raw.size()) return false;
+        body.append(raw, pos, size);
+        pos += size + 2;
+    }
+    return false;
+}
+
+std::string lowercase(std::string text) {
+    for (auto& c : text) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return text;
+}
+
+} // namespace http_detail
+
+class HttpClient {
+private:
+    int timeout_ms;
+    std::string user_agent;
+    
+    // Plain or TLS byte stream over a connected socket
+    class Connection {
+    private:
+        int fd;
+        #ifdef HAVE_OPENSSL
+        SSL_CTX* ctx = nullptr;
+        SSL* ssl = nullptr;
+        #endif
+        
+    public:
+        explicit Connection(int socket_fd) : fd(socket_fd) {}
+        
+        ~Connection() {
+            #ifdef HAVE_OPENSSL
+                if (ssl) {
+                    SSL_shutdown(ssl);
+                    SSL_free(ssl);
+                }
+                if (ctx) SSL_CTX_free(ctx);
+            #endif
+            if (fd >= 0) close(fd);
+        }
+        
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
+        
+        bool start_tls(const std::string& host, std::string& error) {
+            #ifdef HAVE_OPENSSL
+                ctx = SSL_CTX_new(TLS_client_method());
+                if (!ctx) {
+                    error = "TLS context setup failed";
+                    return false;
+                }
+                SSL_CTX_set_default_verify_paths(ctx);
+                SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+                ssl = SSL_new(ctx);
+                SSL_set_fd(ssl, fd);
+                SSL_set_tlsext_host_name(ssl, host.c_str());
+                SSL_set1_host(ssl, host.c_str());
+                if (SSL_connect(ssl) != 1) {
+                    char buffer[256];
+                    ERR_error_string_n(ERR_get_error(), buffer, sizeof(buffer));
+                    error = std::string("TLS handshake with ") + host + " failed: " + buffer;
+                    return false;
+                }
+                return true;
+            #else
+                (void)host;
+                error = "https is not supported by this build (compile with -DHAVE_OPENSSL)";
+                return false;
+            #endif
+        }
+        
+        bool write_all(const std::string& data) {
+            size_t sent = 0;
+            while (sent < data.size()) {
+                ssize_t n;
+                #ifdef HAVE_OPENSSL
+                if (ssl) {
+                    n = SSL_write(ssl, data.data() + sent, static_cast<int>(data.size() - sent));
+                } else
+                #endif
+                {
+                    n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+                    if (n < 0 && errno == EINTR) continue;
+                }
+                if (n <= 0) return false;
+                sent += static_cast<size_t>(n);
+            }
+            return true;
+        }
+        
+        // Appends everything until the peer closes; false on a read error or timeout
+        bool read_all(std::string& out) {
+            char buffer[16384];
+            while (true) {
+                ssize_t n;
+                #ifdef HAVE_OPENSSL
+                if (ssl) {
+                    n = SSL_read(ssl, buffer, sizeof(buffer));
+                    if (n <= 0) return SSL_get_error(ssl, static_cast<int>(n)) == SSL_ERROR_ZERO_RETURN || !out.empty();
+                } else
+                #endif
+                {
+                    n = recv(fd, buffer, sizeof(buffer), 0);
+                    if (n < 0 && errno == EINTR) continue;
+                    if (n == 0) return true;
+                    if (n < 0) return false;
+                }
+                out.append(buffer, static_cast<size_t>(n));
+            }
+        }
+    };
+    
+public:
+    HttpClient(int timeout_seconds = 30, const std::string& agent = "benchmark-runner")
+        : timeout_ms(timeout_seconds * 1000), user_agent(agent) {}
+    
+    HttpResponse request(const std::string& method, const std::string& url,
+                         const std::vector<std::pair<std::string, std::string>>& headers = {},
+                         const std::string& body = "") {
+        HttpResponse response;
+        HttpUrl target;
+        if (!http_detail::parse_url(url, target)) {
+            response.error = "unsupported URL: " + url;
+            return response;
+        }
+        
+        int fd = http_detail::connect_to(target.host, target.port, timeout_ms, response.error);
+        if (fd < 0) return response;
+        Connection connection(fd);
+        if (target.tls && !connection.start_tls(target.host, response.error)) return response;
+        
+        std::string request_text = method + " " + target.path + " HTTP/1.1\r\n";
+        request_text += "Host: " + target.host + "\r\n";
+        request_text += "User-Agent: " + user_agent + "\r\n";
+        request_text += "Connection: close\r\n";
+        for (const auto& header : headers) {
+            request_text += header.first + ": " + header.second + "\r\n";
+        }
+        if (!body.empty() || method == "POST" || method == "PATCH" || method == "PUT") {
+            request_text += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+        }
+        request_text += "\r\n" + body;
+        
+        if (!connection.write_all(request_text)) {
+            response.error = "send to " + target.host + " failed";
+            return response;
+        }
+        
+        std::string raw;
+        bool complete = connection.read_all(raw);
+        size_t header_end = raw.find("\r\n\r\n");
+        if (header_end == std::string::npos) {
+            response.error = complete ? "malformed response from " + target.host : "no response from " + target.host;
+            return response;
+        }
+        
+        // Status line: HTTP/1.1 200 OK
+        size_t space = raw.find(' ');
+        if (space == std::string::npos || space > header_end) {
+            response.error = "malformed status line";
+            return response;
+        }
+        response.status = std::atoi(raw.c_str() + space + 1);
+        
+        std::string header_block = http_detail::lowercase(raw.substr(0, header_end));
+        std::string payload = raw.substr(header_end + 4);
+        if (header_block.find("transfer-encoding: chunked") != std::string::npos) {
+            if (!http_detail::dechunk(payload, response.body)) {
+                response.error = "truncated chunked response";
+            }
+        } else {
+            size_t length_at = header_block.find("content-length:");
+            if (length_at != std::string::npos) {
+                size_t length = std::strtoul(header_block.c_str() + length_at + 15, nullptr, 10);
+                if (payload.size() < length) response.error = "truncated response";
+                payload.resize(std::min(payload.size(), length));
+            }
+            response.body = payload;
+        }
+        return response;
+    }
+};
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cstdio>
+#include <cstdint>
+
+// Minimal JSON support for the Gist API: a streaming writer with correct string
+// escaping and a scanner that pulls string fields out of a response.
+
+std::string json_escape(const std::string& text) {
+    std::string out;
+    out.reserve(text.size() + 16);
+    for (unsigned char c : text) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    out += buffer;
+                } else {
+                    out += static_cast<char>(c); // UTF-8 passes through unchanged
+                }
+        }
+    }
+    return out;
+}
+
+class JsonWriter {
+private:
+    std::string out;
+    std::vector<bool> needs_comma;
+    bool after_key = false;
+    
+    void separator() {
+        if (after_key) {
+            after_key = false;
+            return;
+        }
+        if (!needs_comma.empty()) {
+            if (needs_comma.back()) out += ",";
+            needs_comma.back() = true;
+        }
+    }
+    
+public:
+    JsonWriter& begin_object() {
+        separator();
+        out += "{";
+        needs_comma.push_back(false);
+        return *this;
+    }
+    
+    JsonWriter& end_object() {
+        out += "}";
+        needs_comma.pop_back();
+        return *this;
+    }
+    
+    JsonWriter& key(const std::string& name) {
+        separator();
+        out += "\"" + json_escape(name) + "\":";
+        after_key = true;
+        return *this;
+    }
+    
+    JsonWriter& value(const std::string& text) {
+        separator();
+        out += "\"" + json_escape(text) + "\"";
+        return *this;
+    }
+    
+    JsonWriter& value(const char* text) {
+        return value(std::string(text));
+    }
+    
+    JsonWriter& value(bool flag) {
+        separator();
+        out += flag ? "true" : "false";
+        return *this;
+    }
+    
+    JsonWriter& value(double number) {
+        separator();
+        std::ostringstream text;
+        text.precision(17);
+        text << number;
+        out += text.str();
+        return *this;
+    }
+    
+    const std::string& str() const {
+        return out;
+    }
+};
+
+namespace json_detail {
+
+void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Value of one hex digit, -1 for anything else
+int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// The four hex digits of a \u escape at json[pos]; false when short or malformed
+bool read_hex4(const std::string& json, size_t pos, uint32_t& value) {
+    if (pos + 4 > json.size()) return false;
+    value = 0;
+    for (size_t i = pos; i < pos + 4; i++) {
+        int digit = hex_digit(json[i]);
+        if (digit < 0) return false;
+        value = (value << 4) | static_cast<uint32_t>(digit);
+    }
+    return true;
+}
+
+// Decodes the string literal starting at json[pos] == '"'; pos ends after the closing quote
+bool read_string(const std::string& json, size_t& pos, std::string& out) {
+    out.clear();
+    pos++;
+    while (pos < json.size()) {
+        char c = json[pos++];
+        if (c == '"') return true;
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (pos >= json.size()) return false;
+        char e = json[pos++];
+        switch (e) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u': {
+                uint32_t cp;
+                if (!read_hex4(json, pos, cp)) return false;
+                pos += 4;
+                // Surrogate pair
+                uint32_t low;
+                if (cp >= 0xD800 && cp < 0xDC00 && pos + 6 <= json.size() && json[pos] == '\\' && json[pos + 1] == 'u' &&
+                    read_hex4(json, pos + 2, low)) {
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        pos += 6;
+                    }
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default: out += e; break; // \" \\ \/
+        }
+    }
+    return false;
+}
+
+} // namespace json_detail
+
+// Value of the first string member called key, at any depth, in document order.
+// Strings are tokenized properly, so a key name inside a value does not match.
+bool json_find_string(const std::string& json, const std::string& key, std::string& value) {
+    size_t pos = 0;
+    std::string token;
+    while (pos < json.size()) {
+        if (json[pos] != '"') {
+            pos++;
+            continue;
+        }
+        if (!json_detail::read_string(json, pos, token)) return false;
+        
+        size_t next = json.find_first_not_of(" \t\r\n", pos);
+        if (next == std::string::npos || json[next] != ':') continue; // a value, not a key
+        if (token != key) continue;
+        
+        size_t start = json.find_first_not_of(" \t\r\n", next + 1);
+        if (start == std::string::npos || json[start] != '"') continue;
+        pos = start;
+        return json_detail::read_string(json, pos, value);
+    }
+    return false;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+
+// Hot kernels are compiled once per x86-64 micro-architecture level (GCC's
+// target_clones); the loader's ifunc resolver binds the best clone the CPU
+// supports, so one binary runs SSE2, SSE4.2, AVX2 or AVX-512 code as the machine
+// allows. Other compilers and targets build the kernels once, for the default target.
+#if defined(__x86_64__) && defined(__linux__) && defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+#define HOT_KERNEL __attribute__((target_clones("default", "arch=x86-64-v2", "arch=x86-64-v3", "arch=x86-64-v4")))
+#define HOT_KERNEL_CLONES 1
+#else
+#define HOT_KERNEL
+#define HOT_KERNEL_CLONES 0
+#endif
+
+// Set by the Makefile: "clones", "pgo" or "pgo-train"
+#ifndef BUILD_FLAVOR
+#define BUILD_FLAVOR "plain"
+#endif
+
+// Clone the resolver picks on this CPU: the highest level it supports
+std::string kernel_isa_level() {
+#if HOT_KERNEL_CLONES
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("x86-64-v4")) return "x86-64-v4";
+    if (__builtin_cpu_supports("x86-64-v3")) return "x86-64-v3";
+    if (__builtin_cpu_supports("x86-64-v2")) return "x86-64-v2";
+    return "x86-64";
+#else
+    return "default target";
+#endif
+}
+
+// Recorded with every result, e.g. "pgo, x86-64-v3"
+std::string build_flavor() {
+    return std::string(BUILD_FLAVOR) + ", " + kernel_isa_level();
+}
+
+namespace dispatch_detail {
+template <typename T>
+volatile T result_sink;
+} // namespace dispatch_detail
+
+// Results a benchmark never reads would otherwise be optimised away with their loop
+template <typename T>
+void keep_result(T value) {
+    dispatch_detail::result_sink<T> = value;
+}
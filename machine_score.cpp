@@ -0,0 +1,165 @@
+#pragma once
+
+#include "benchmark_stats.cpp"
+#include "results_history.cpp"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cmath>
+
+// Composite machine score. Every case is normalised to a reference machine's samples
+// in the results history from the same build (speed ratio, so higher is better whatever
+// the metric), and the ratios are combined with a geometric mean, scaled so the
+// reference scores 1000.
+// Each case's ratio gets a variance from the spread of its repeated samples on both
+// sides (delta method on the log of the ratio of means), and the log-mean's variance
+// gives the 95% interval of the score; single samples leave it unknown.
+
+// One case of the current run as the scorer sees it
+struct ScoreInput {
+    std::string case_name;
+    std::string metric;         // history metric; bandwidth metrics are higher-is-better
+    std::string group;          // "compute" or "memory"
+    bool threaded;
+    std::vector<double> samples;
+};
+
+struct ScoreEstimate {
+    double score = 0.0;         // 1000 = reference machine
+    double low = 0.0;           // 95% interval; equal to score when there is no spread
+    double high = 0.0;
+    int cases = 0;
+    bool has_interval = false;
+    
+    bool valid() const { return cases > 0; }
+};
+
+struct MachineScore {
+    std::string reference_host;
+    std::string reference_machine;
+    ScoreEstimate composite;
+    ScoreEstimate single_thread;
+    ScoreEstimate multi_thread;
+    ScoreEstimate compute;
+    ScoreEstimate memory;
+    std::vector<std::string> skipped;   // cases the reference has no samples for
+};
+
+class MachineScorer {
+private:
+    const ResultsHistory& history;
+    std::string reference_host;
+    std::string build;
+    int reference_runs;
+    
+    // Log speed ratio of one case and its variance
+    struct CaseRatio {
+        double log_ratio;
+        double variance;
+        bool has_spread;
+    };
+    
+    static double relative_variance(const std::vector<double>& samples) {
+        double mean = sample_mean(samples);
+        if (samples.size() < 2 || mean == 0.0) return 0.0;
+        double relative_se = sample_stddev(samples) / mean;
+        return relative_se * relative_se / samples.size();
+    }
+    
+    static ScoreEstimate combine(const std::vector<CaseRatio>& ratios) {
+        ScoreEstimate estimate;
+        if (ratios.empty()) return estimate;
+        double sum = 0.0, variance = 0.0;
+        bool spread = true;
+        for (const auto& ratio : ratios) {
+            sum += ratio.log_ratio;
+            variance += ratio.variance;
+            spread = spread && ratio.has_spread;
+        }
+        double k = static_cast<double>(ratios.size());
+        double mean = sum / k;
+        double half_width = 1.96 * std::sqrt(variance) / k;
+        estimate.score = 1000.0 * std::exp(mean);
+        estimate.low = 1000.0 * std::exp(mean - half_width);
+        estimate.high = 1000.0 * std::exp(mean + half_width);
+        estimate.cases = static_cast<int>(ratios.size());
+        estimate.has_interval = spread;
+        return estimate;
+    }
+    
+public:
+    MachineScorer(const ResultsHistory& results_history, const std::string& host, const std::string& build_key,
+                  int runs = 10)
+        : history(results_history), reference_host(host), build(build_key), reference_runs(runs) {}
+    
+    static bool higher_is_better(const std::string& metric) {
+        return metric.find("bandwidth") == 0;
+    }
+    
+    MachineScore score(const std::vector<ScoreInput>& inputs) const {
+        MachineScore result;
+        result.reference_host = reference_host;
+        result.reference_machine = history.machine_of(reference_host, build);
+        
+        std::vector<CaseRatio> all, single, multi, compute, memory;
+        for (const auto& input : inputs) {
+            // The reference's earliest runs, so its own later runs do not move the baseline
+            std::vector<double> reference = history.collect_samples(reference_host, build, input.case_name, input.metric,
+                                                                    reference_runs, true);
+            double reference_mean = sample_mean(reference);
+            double current_mean = sample_mean(input.samples);
+            if (reference.empty() || input.samples.empty() || reference_mean <= 0.0 || current_mean <= 0.0) {
+                result.skipped.push_back(input.case_name);
+                continue;
+            }
+            
+            double log_ratio = std::log(reference_mean / current_mean);
+            if (higher_is_better(input.metric)) log_ratio = -log_ratio;
+            CaseRatio ratio = {log_ratio, relative_variance(reference) + relative_variance(input.samples),
+                               reference.size() > 1 && input.samples.size() > 1};
+            
+            all.push_back(ratio);
+            (input.threaded ? multi : single).push_back(ratio);
+            (input.group == "memory" ? memory : compute).push_back(ratio);
+        }
+        
+        result.composite = combine(all);
+        result.single_thread = combine(single);
+        result.multi_thread = combine(multi);
+        result.compute = combine(compute);
+        result.memory = combine(memory);
+        return result;
+    }
+};
+
+void print_machine_score(const MachineScore& score) {
+    std::cout << "\nMachine score (geometric mean of speed ratios, reference "
+              << (score.reference_machine.empty() ? score.reference_host : score.reference_machine)
+              << " = 1000):" << std::endl;
+    const std::pair<const char*, const ScoreEstimate*> rows[] = {
+        {"Composite", &score.composite}, {"Single-thread", &score.single_thread},
+        {"Multi-thread", &score.multi_thread}, {"Compute", &score.compute}, {"Memory", &score.memory}
+    };
+    for (const auto& row : rows) {
+        std::cout << std::left << std::setw(16) << row.first << std::right;
+        if (!row.second->valid()) {
+            std::cout << std::setw(8) << "-" << "  (no cases)" << std::endl;
+            continue;
+        }
+        std::cout << std::fixed << std::setprecision(0) << std::setw(8) << row.second->score;
+        if (row.second->has_interval) {
+            std::cout << "  95% CI " << row.second->low << " - " << row.second->high;
+        } else {
+            std::cout << "  (no interval, needs --repeat and repeated reference samples)";
+        }
+        std::cout << "  [" << row.second->cases << " cases]" << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+    }
+    if (!score.skipped.empty()) {
+        std::cout << "Not scored (no reference samples): ";
+        for (size_t i = 0; i < score.skipped.size(); i++) std::cout << (i > 0 ? ", " : "") << score.skipped[i];
+        std::cout << std::endl;
+    }
+}
@@ -1,207 +1,482 @@
+#include "host_fingerprint.cpp"
+#include "mandelbrot_renderer.cpp"
+#include "tile_farm.cpp"
+#include "scaling_sweep.cpp"
+#include "batch_renderer.cpp"
+#include "smooth_coloring.cpp"
+#include <unordered_map>
+#include <random>
 #include <iostream>
-#include <complex>
-#include <chrono>
-#include <thread>
-#include <cstdlib>
 #include <fstream>
-#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cmath>
 
-class MandelbrotRenderer {
-private:
-    int width, height;
-    int max_iterations;
-    
-    int mandelbrot_iterations(std::complex<double> c) {
-        std::complex<double> z = 0;
-        for (int i = 0; i < max_iterations; i++) {
-            if (std::abs(z) > 2.0) return i;
-            z = z * z + c;
+struct BenchmarkOptions {
+    std::string only;       // run just this section: demo, zooms, resolutions, aa, progressive, farm, scaling, batch or coloring
+    int threads = 0;        // 0 = every hardware thread
+    int sweep_max = 1024;   // largest image side of the scaling sweep
+    int jobs = 400;         // thumbnails in the batch section
+    int workers = 4;        // worker processes of the farm section; its scaling runs go up to this
+    std::string ppm;        // coloring section writes its equalised image here
+    
+    bool wants(const std::string& section) const {
+        return only.empty() || only == section;
+    }
+    
+    static bool known_section(const std::string& name) {
+        const char* sections[] = {"demo", "zooms", "resolutions", "aa", "progressive", "farm", "scaling", "batch", "coloring"};
+        return std::find(std::begin(sections), std::end(sections), name) != std::end(sections);
+    }
+};
+
+bool parse_options(int argc, char* argv[], BenchmarkOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string value;
+        size_t eq = arg.find('=');
+        if (eq != std::string::npos) {
+            value = arg.substr(eq + 1);
+            arg = arg.substr(0, eq);
+        }
+        try {
+            if (arg == "--only" && !value.empty()) {
+                if (!BenchmarkOptions::known_section(value)) throw std::invalid_argument(value);
+                options.only = value;
+            } else if (arg == "--threads") {
+                options.threads = std::stoi(value);
+                if (options.threads < 0) throw std::invalid_argument(value);
+            } else if (arg == "--sweep-max") {
+                options.sweep_max = std::stoi(value);
+                if (options.sweep_max < 64) throw std::invalid_argument(value);
+            } else if (arg == "--workers") {
+                options.workers = std::stoi(value);
+                if (options.workers < 1) throw std::invalid_argument(value);
+            } else if (arg == "--jobs") {
+                options.jobs = std::stoi(value);
+                if (options.jobs < 1) throw std::invalid_argument(value);
+            } else if (arg == "--ppm" && !value.empty()) {
+                options.ppm = value;
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            std::cout << "Invalid value for " << arg << ": '" << value << "'" << std::endl;
+            return false;
         }
-        return max_iterations;
     }
+    return true;
+}
+
+void print_usage() {
+    std::cout << "Usage: mandelbrot_benchmark [options]\n"
+              << "  --only=SECTION   run one section: demo, zooms, resolutions, aa,\n                   progressive, farm, scaling, batch, coloring\n"
+              << "  --threads=N      render threads for the aa, progressive, batch and coloring sections (default: all)\n"
+              << "  --sweep-max=N    largest image side of the scaling sweep (default 1024)\n"
+              << "  --workers=N      worker processes of the farm section (default 4)\n"
+              << "  --jobs=N         thumbnails rendered by the batch section (default 400)\n"
+              << "  --ppm=FILE       write the coloring section's 4k image as a binary PPM\n";
+}
+
+// Root-mean-square shade difference between two images of the same size
+double shade_rmse(const AntiAliasedImage& a, const AntiAliasedImage& b) {
+    double sum = 0.0;
+    for (size_t i = 0; i < a.shade.size(); i++) {
+        double d = a.shade[i] - b.shade[i];
+        sum += d * d;
+    }
+    return std::sqrt(sum / a.shade.size());
+}
+
+// Adaptive versus full supersampling, both scored against a dense jittered reference
+void run_antialiasing(const BenchmarkOptions& options) {
+    const int width = 240, height = 180, iterations = 150;
+    const double x_min = -2.2, x_max = 0.8, y_min = -1.125, y_max = 1.125;
+    MandelbrotRenderer renderer(width, height, iterations);
+    
+    // Different seed from the images under test, so the reference shares no samples with them
+    AntiAliasedImage reference = renderer.render_supersampled(x_min, x_max, y_min, y_max, 8,
+                                                              SamplePattern::Jittered, options.threads, 99);
+    std::cout << width << "x" << height << ", " << iterations << " iter; reference 8x8 jittered: "
+              << reference.elapsed_ms << " ms" << std::endl;
     
-    std::string get_colored_char(int iterations) {
-        if (iterations >= max_iterations) {
-            return "\033[40m \033[0m"; // Black background for Mandelbrot set
+    struct Case {
+        std::string name;
+        int n;
+        double threshold;       // < 0: full supersampling
+        SamplePattern pattern;
+    };
+    std::vector<Case> cases = {
+        {"1 sample", 1, -1.0, SamplePattern::Jittered},
+        {"full 2x2 rotated", 2, -1.0, SamplePattern::RotatedGrid},
+        {"full 4x4 jittered", 4, -1.0, SamplePattern::Jittered},
+        {"adaptive 2x2 rotated", 2, 0.02, SamplePattern::RotatedGrid},
+        {"adaptive 4x4 jittered", 4, 0.02, SamplePattern::Jittered},
+        {"adaptive 4x4 t=0.05", 4, 0.05, SamplePattern::Jittered},
+        {"adaptive 4x4 t=0.10", 4, 0.10, SamplePattern::Jittered}
+    };
+    
+    std::cout << std::left << std::setw(24) << "Mode" << std::right << std::setw(10) << "Time ms"
+              << std::setw(13) << "Samples/px" << std::setw(11) << "Refined%" << std::setw(10) << "RMSE"
+              << std::setw(13) << "vs full NxN" << std::endl;
+    std::vector<double> full_ms(5, 0.0);
+    for (const auto& c : cases) {
+        AntiAliasedImage image = c.threshold < 0.0
+            ? renderer.render_supersampled(x_min, x_max, y_min, y_max, c.n, c.pattern, options.threads)
+            : renderer.render_adaptive(x_min, x_max, y_min, y_max, c.n, c.threshold, c.pattern, options.threads);
+        if (c.threshold < 0.0) full_ms[c.n] = image.elapsed_ms;
+        double pixels = static_cast<double>(width) * height;
+        std::cout << std::left << std::setw(24) << c.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << image.elapsed_ms << std::setprecision(2) << std::setw(13) << image.samples / pixels
+                  << std::setprecision(1) << std::setw(11) << 100.0 * image.refined_pixels / pixels
+                  << std::setprecision(4) << std::setw(10) << shade_rmse(image, reference);
+        // Cost relative to brute force with the same pattern, the quality it approximates
+        if (c.threshold >= 0.0 && image.elapsed_ms > 0.0 && full_ms[c.n] > 0.0) {
+            std::cout << std::setprecision(2) << std::setw(12) << full_ms[c.n] / image.elapsed_ms << "x";
         }
-        
-        // Color gradients: Blue -> Cyan -> Green -> Yellow -> Red -> Magenta
-        const std::string colors[] = {
-            "\033[44m ", // Blue
-            "\033[46m ", // Cyan  
-            "\033[42m ", // Green
-            "\033[43m ", // Yellow
-            "\033[41m ", // Red
-            "\033[45m "  // Magenta
-        };
-        
-        int color_index = (iterations * 6) / max_iterations;
-        if (color_index >= 6) color_index = 5;
-        
-        return colors[color_index] + "\033[0m";
+        std::cout << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
     }
+}
+
+// Pipelined progressive rendering: compute threads never wait for the display thread,
+// which draws 20 frames per second into /dev/null
+void run_progressive(const BenchmarkOptions& options) {
+    struct View {
+        std::string name;
+        double x_min, x_max, y_min, y_max;
+        int iterations;
+        size_t ring;            // 0: room for every row
+    };
+    std::vector<View> views = {
+        {"Full view", -2.5, 1.0, -1.25, 1.25, 100, 0},
+        {"Deep zoom", -0.7463, -0.7453, 0.1102, 0.1112, 500, 0},
+        {"Deep zoom, 16-row ring", -0.7463, -0.7453, 0.1102, 0.1112, 500, 16}
+    };
+    const int size = 200;
+    std::ofstream sink("/dev/null");
     
-    char get_char(int iterations) {
-        if (iterations >= max_iterations) return '#';
-        
-        // More detailed character gradient
-        const char chars[] = " .:-=+*#%@";
-        int index = iterations * (sizeof(chars) - 2) / max_iterations;
-        return chars[index];
+    std::cout << std::left << std::setw(24) << "View" << std::right << std::setw(10) << "Plain ms"
+              << std::setw(12) << "Compute ms" << std::setw(12) << "Preview ms" << std::setw(12) << "Display ms"
+              << std::setw(8) << "Frames" << std::setw(13) << "Max backlog" << std::setw(14) << "Mean backlog"
+              << std::setw(9) << "Dropped" << std::endl;
+    for (const auto& view : views) {
+        MandelbrotRenderer renderer(size, size, view.iterations);
+        double plain_ms = renderer.render(view.x_min, view.x_max, view.y_min, view.y_max, false);
+        ProgressiveStats stats = renderer.render_progressive(view.x_min, view.x_max, view.y_min, view.y_max,
+                                                             &sink, false, options.threads, 50.0, view.ring);
+        std::cout << std::left << std::setw(24) << view.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << plain_ms << std::setw(12) << stats.compute_ms
+                  << std::setw(12) << stats.first_preview_ms << std::setw(12) << stats.display_ms
+                  << std::setw(8) << stats.frames << std::setw(13) << stats.max_backlog
+                  << std::setw(14) << stats.mean_backlog << std::setw(9) << stats.dropped << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
     }
+}
+
+// Tile size tuning, worker scaling, inline versus shared-memory tiles and a worker
+// crash, all checked against a single-process render of the same view
+void run_tile_farm(const BenchmarkOptions& options) {
+    const int width = 480, height = 480, iterations = 150;
+    const double x_min = -1.0, x_max = 0.0, y_min = -0.5, y_max = 0.5;
     
-public:
-    MandelbrotRenderer(int w, int h, int max_iter) 
-        : width(w), height(h), max_iterations(max_iter) {}
+    CycleTimer& timer = CycleTimer::instance();
+    MandelbrotRenderer renderer(width, height, iterations);
+    std::vector<int32_t> reference(static_cast<size_t>(width) * height);
+    uint64_t t0 = timer.start();
+    renderer.render_tile(x_min, x_max, y_min, y_max, 0, 0, width, height, reference.data());
+    double single_ms = timer.elapsed_ms(t0, timer.stop());
+    unsigned hw = std::thread::hardware_concurrency();
+    std::cout << width << "x" << height << ", " << iterations << " iter; single process: " << single_ms
+              << " ms; hardware threads: " << hw << std::endl;
     
-    double render(double x_min, double x_max, double y_min, double y_max, 
-                  bool visualize = true, bool progressive = false, bool use_color = false) {
-        auto start_time = std::chrono::high_resolution_clock::now();
-        
-        if (visualize) {
-            std::cout << "\033[2J\033[H"; // Clear screen
+    auto report = [&](const std::string& label, const TileFarmOptions& farm, double base_ms) {
+        std::vector<int32_t> image;
+        TileFarmStats stats = render_tile_farm(width, height, iterations, x_min, x_max, y_min, y_max, farm, image);
+        int busiest = 0, idlest = stats.tiles;
+        for (int n : stats.tiles_per_worker) {
+            busiest = std::max(busiest, n);
+            idlest = std::min(idlest, n);
         }
-        
-        double x_scale = (x_max - x_min) / width;
-        double y_scale = (y_max - y_min) / height;
-        
-        for (int row = 0; row < height; row++) {
-            double y = y_min + row * y_scale;
-            
-            for (int col = 0; col < width; col++) {
-                double x = x_min + col * x_scale;
-                std::complex<double> c(x, y);
-                
-                int iterations = mandelbrot_iterations(c);
-                
-                if (visualize) {
-                    if (use_color) {
-                        std::cout << get_colored_char(iterations);
-                    } else {
-                        std::cout << get_char(iterations);
-                    }
-                }
-            }
-            
-            if (visualize) {
-                std::cout << std::endl;
-                if (progressive && row % 2 == 0) {
-                    std::cout.flush();
-                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
-                }
-            }
+        std::cout << std::left << std::setw(22) << label << std::right << std::setw(8) << farm.workers
+                  << std::setw(6) << farm.tile_size << std::setw(7) << stats.tiles << std::fixed << std::setprecision(1)
+                  << std::setw(10) << stats.elapsed_ms << std::setprecision(2)
+                  << std::setw(9) << width * static_cast<double>(height) / (stats.elapsed_ms * 1000.0)
+                  << std::setw(9) << base_ms / stats.elapsed_ms
+                  << std::setw(11) << (std::to_string(idlest) + "-" + std::to_string(busiest))
+                  << std::setw(10) << stats.reissued << std::setw(7)
+                  << (stats.ok && image == reference ? "yes" : "NO") << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+        if (!stats.error.empty()) std::cout << "  " << stats.error << std::endl;
+        return stats.elapsed_ms;
+    };
+    
+    std::cout << std::left << std::setw(22) << "Run" << std::right << std::setw(8) << "Workers" << std::setw(6) << "Tile"
+              << std::setw(7) << "Tiles" << std::setw(10) << "Time ms" << std::setw(9) << "Mpix/s"
+              << std::setw(9) << "Speedup" << std::setw(11) << "Per worker" << std::setw(10) << "Reissued"
+              << std::setw(7) << "Match" << std::endl;
+    
+    // Small tiles balance better, big tiles pay fewer round trips
+    TileFarmOptions farm;
+    farm.workers = options.workers;
+    double best_ms = 0.0;
+    int best_tile = 64;
+    for (int tile : {16, 32, 64, 128}) {
+        farm.tile_size = tile;
+        double ms = report("tile size", farm, single_ms);
+        if (best_ms == 0.0 || ms < best_ms) {
+            best_ms = ms;
+            best_tile = tile;
         }
-        
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
-        
-        return duration.count() / 1000.0; // Return time in milliseconds
     }
-};
+    
+    farm.tile_size = best_tile;
+    double one_worker_ms = 0.0;
+    // 1, 2, 4, ... workers, and --workers itself when it is not a power of two
+    std::vector<int> counts;
+    for (int workers = 1; workers < options.workers; workers *= 2) counts.push_back(workers);
+    counts.push_back(options.workers);
+    for (int workers : counts) {
+        farm.workers = workers;
+        double ms = report("scaling", farm, one_worker_ms > 0.0 ? one_worker_ms : single_ms);
+        if (workers == 1) one_worker_ms = ms;
+    }
+    
+    farm.workers = options.workers;
+    farm.shared_memory = false;
+    report("inline tiles", farm, single_ms);
+    if (options.workers > 1) {
+        farm.shared_memory = true;
+        farm.kill_worker_after = 10;
+        report("worker 0 killed", farm, single_ms);
+    } else {
+        std::cout << "Kill test skipped: it needs a second worker to take over" << std::endl;
+    }
+}
 
-std::string get_system_info() {
-    std::stringstream info;
-    
-    // Get OS info
-    #ifdef __APPLE__
-        info << "OS: macOS ";
-        std::system("sw_vers -productVersion > /tmp/macos_version.txt 2>/dev/null");
-        std::ifstream version_file("/tmp/macos_version.txt");
-        std::string version;
-        if (std::getline(version_file, version)) {
-            info << version;
-        }
-        version_file.close();
-        std::system("rm -f /tmp/macos_version.txt");
-        info << "\n";
-    #elif __linux__
-        info << "OS: Linux ";
-        std::system("uname -r > /tmp/linux_version.txt 2>/dev/null");
-        std::ifstream version_file("/tmp/linux_version.txt");
-        std::string version;
-        if (std::getline(version_file, version)) {
-            info << version;
-        }
-        version_file.close();
-        std::system("rm -f /tmp/linux_version.txt");
-        info << "\n";
-    #else
-        info << "OS: Unknown\n";
-    #endif
+// The full view rendered into an iteration buffer, 64x64 upwards in steps of sqrt(2)
+// in side length, best of three. The buffer is the working set.
+void run_scaling(const BenchmarkOptions& options) {
+    SweepCase sweep = {
+        "Mandelbrot",
+        [](int size) {
+            CycleTimer& timer = CycleTimer::instance();
+            MandelbrotRenderer renderer(size, size, 100);
+            std::vector<int32_t> image(static_cast<size_t>(size) * size);
+            uint64_t start = timer.start();
+            renderer.render_tile(-2.5, 1.0, -1.25, 1.25, 0, 0, size, size, image.data());
+            return timer.elapsed_ms(start, timer.stop());
+        },
+        [](int size) { return static_cast<double>(size) * size; },
+        [](int size) { return static_cast<double>(sizeof(int32_t)) * size * size; }
+    };
+    std::vector<SweepPoint> points = run_sweep(sweep, geometric_sizes(64, options.sweep_max, std::sqrt(2.0)), 3);
+    print_sweep("Image", points, analyze_sweep(points));
+}
+
+// FNV-1a over a job's iteration counts, to compare batch output with the serial renders
+uint64_t image_hash(const int32_t* iterations, size_t count) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < count; i++) {
+        hash ^= static_cast<uint32_t>(iterations[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Thumbnails around a few well-known spots at random depths, sizes and iteration budgets
+std::vector<RenderJob> thumbnail_jobs(int count, uint32_t seed) {
+    const double spots[][2] = {{-0.5, 0.0}, {-0.7453, 0.1127}, {-0.1011, 0.9563}, {-1.2500, 0.0200},
+                               {0.2850, 0.0100}, {-0.7700, 0.1000}, {-1.7490, 0.0000}, {-0.1600, 1.0405}};
+    const int sizes[] = {32, 48, 64, 80, 96, 128};
+    const int budgets[] = {32, 64, 128, 256, 512, 1024};
+    std::mt19937 rng(seed);
+    std::vector<RenderJob> jobs;
+    for (int i = 0; i < count; i++) {
+        const double* spot = spots[rng() % 8];
+        double half = 1.5 * std::pow(10.0, -std::uniform_real_distribution<double>(0.0, 4.0)(rng));
+        RenderJob job;
+        job.width = sizes[rng() % 6];
+        job.height = job.width * 3 / 4;
+        job.max_iterations = budgets[rng() % 6];
+        job.x_min = spot[0] - half;
+        job.x_max = spot[0] + half;
+        job.y_min = spot[1] - half * 0.75;
+        job.y_max = spot[1] + half * 0.75;
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+// One renderer per job in submission order (what callers do today) against the batch
+// scheduler with and without cost ordering and job splitting
+void run_batch(const BenchmarkOptions& options) {
+    std::vector<RenderJob> jobs = thumbnail_jobs(options.jobs, 42);
+    CycleTimer& timer = CycleTimer::instance();
     
-    // Get CPU info
-    #ifdef __APPLE__
-        info << "CPU: ";
-        std::system("sysctl -n machdep.cpu.brand_string > /tmp/cpu_info.txt 2>/dev/null");
-        std::ifstream cpu_file("/tmp/cpu_info.txt");
-        std::string cpu;
-        if (std::getline(cpu_file, cpu)) {
-            info << cpu;
-        }
-        cpu_file.close();
-        std::system("rm -f /tmp/cpu_info.txt");
-        info << "\n";
-    #elif __linux__
-        info << "CPU: ";
-        std::system("grep 'model name' /proc/cpuinfo | head -1 | cut -d':' -f2 | sed 's/^ *//' > /tmp/cpu_info.txt 2>/dev/null");
-        std::ifstream cpu_file("/tmp/cpu_info.txt");
-        std::string cpu;
-        if (std::getline(cpu_file, cpu)) {
-            info << cpu;
-        }
-        cpu_file.close();
-        std::system("rm -f /tmp/cpu_info.txt");
-        info << "\n";
-    #else
-        info << "CPU: Unknown\n";
-    #endif
+    std::vector<uint64_t> reference(jobs.size());
+    std::vector<double> serial_latency;
+    uint64_t start = timer.start();
+    for (size_t j = 0; j < jobs.size(); j++) {
+        const RenderJob& job = jobs[j];
+        MandelbrotRenderer renderer(job.width, job.height, job.max_iterations);
+        std::vector<int32_t> image(static_cast<size_t>(job.width) * job.height);
+        renderer.render_tile(job.x_min, job.x_max, job.y_min, job.y_max, 0, 0, job.width, job.height, image.data());
+        reference[j] = image_hash(image.data(), image.size());
+        serial_latency.push_back(timer.elapsed_ms(start, timer.stop()));
+    }
+    double serial_ms = serial_latency.back();
+    std::cout << jobs.size() << " thumbnails (32-128 px wide, 32-1024 iter); hardware threads: "
+              << std::thread::hardware_concurrency() << std::endl;
     
-    // Get memory info
-    #ifdef __APPLE__
-        info << "Memory: ";
-        std::system("sysctl -n hw.memsize | awk '{print $1/1024/1024/1024 \" GB\"}' > /tmp/mem_info.txt 2>/dev/null");
-        std::ifstream mem_file("/tmp/mem_info.txt");
-        std::string mem;
-        if (std::getline(mem_file, mem)) {
-            info << mem;
-        }
-        mem_file.close();
-        std::system("rm -f /tmp/mem_info.txt");
-        info << "\n";
-    #elif __linux__
-        info << "Memory: ";
-        std::system("grep MemTotal /proc/meminfo | awk '{print $2/1024/1024 \" GB\"}' > /tmp/mem_info.txt 2>/dev/null");
-        std::ifstream mem_file("/tmp/mem_info.txt");
-        std::string mem;
-        if (std::getline(mem_file, mem)) {
-            info << mem;
-        }
-        mem_file.close();
-        std::system("rm -f /tmp/mem_info.txt");
-        info << "\n";
-    #else
-        info << "Memory: Unknown\n";
-    #endif
+    std::cout << std::left << std::setw(24) << "Mode" << std::right << std::setw(8) << "Threads" << std::setw(7) << "Tasks"
+              << std::setw(10) << "Time ms" << std::setw(9) << "Jobs/s" << std::setw(9) << "p50 ms" << std::setw(9) << "p99 ms"
+              << std::setw(9) << "Max ms" << std::setw(12) << "Service p99" << std::setw(7) << "Util%"
+              << std::setw(9) << "Buffers" << std::setw(7) << "Match" << std::endl;
+    std::cout << std::left << std::setw(24) << "serial, fresh renderer" << std::right << std::setw(8) << 1
+              << std::setw(7) << jobs.size() << std::fixed << std::setprecision(1) << std::setw(10) << serial_ms
+              << std::setw(9) << jobs.size() / (serial_ms / 1000.0)
+              << std::setprecision(2) << std::setw(9) << serial_latency[serial_latency.size() / 2]
+              << std::setw(9) << serial_latency[serial_latency.size() * 99 / 100] << std::setw(9) << serial_ms
+              << std::setw(12) << "-" << std::setw(7) << "-" << std::setw(9) << jobs.size() << std::setw(7) << "-" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6);
+    
+    struct Mode {
+        std::string name;
+        bool order_by_cost;
+        bool split_jobs;
+    };
+    const std::vector<Mode> modes = {
+        {"batch, submission order", false, false},
+        {"batch, by cost", true, false},
+        {"batch, by cost + bands", true, true},
+        {"again, warm buffers", true, true}
+    };
+    BatchRenderer batch;
+    for (const auto& mode : modes) {
+        BatchRenderOptions batch_options;
+        batch_options.threads = options.threads;
+        batch_options.order_by_cost = mode.order_by_cost;
+        batch_options.split_jobs = mode.split_jobs;
+        std::vector<uint64_t> hashes(jobs.size());
+        BatchRenderStats stats = batch.render(jobs, batch_options, [&](int j, const RenderJob& job, const int32_t* iterations) {
+            hashes[j] = image_hash(iterations, static_cast<size_t>(job.width) * job.height);
+        });
+        std::cout << std::left << std::setw(24) << mode.name << std::right << std::setw(8) << stats.threads
+                  << std::setw(7) << stats.tasks << std::fixed << std::setprecision(1) << std::setw(10) << stats.elapsed_ms
+                  << std::setw(9) << stats.jobs_per_second << std::setprecision(2) << std::setw(9) << stats.latency_p50_ms
+                  << std::setw(9) << stats.latency_p99_ms << std::setw(9) << stats.latency_max_ms
+                  << std::setw(12) << stats.service_p99_ms << std::setprecision(1) << std::setw(7) << 100.0 * stats.utilization
+                  << std::setw(9) << stats.buffer_allocations << std::setw(7) << (hashes == reference ? "yes" : "NO") << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+    }
+}
+
+// Distinct colours, and the share of escaped pixels taking the most common one
+void color_spread(const ColoredImage& image, const EscapeImage& escape, size_t& colors, double& top_share) {
+    std::unordered_map<uint32_t, long> counts;
+    long escaped = 0;
+    for (size_t i = 0; i < image.rgb.size(); i++) {
+        if (escape.iterations[i] >= escape.max_iterations) continue;
+        counts[image.rgb[i]]++;
+        escaped++;
+    }
+    long top = 0;
+    for (const auto& entry : counts) top = std::max(top, entry.second);
+    colors = counts.size();
+    top_share = escaped > 0 ? static_cast<double>(top) / escaped : 0.0;
+}
+
+void write_ppm(const std::string& path, const ColoredImage& image) {
+    std::ofstream out(path, std::ios::binary);
+    out << "P6\n" << image.width << " " << image.height << "\n255\n";
+    for (uint32_t rgb : image.rgb) {
+        char pixel[3] = {static_cast<char>(rgb >> 16), static_cast<char>(rgb >> 8), static_cast<char>(rgb)};
+        out.write(pixel, 3);
+    }
+}
+
+// The iteration pass once, then the old banding and the smooth, equalised pass with
+// the scalar and AVX2 lookups on one thread and on all of them
+void run_coloring(const BenchmarkOptions& options) {
+    const int width = 3840, height = 2160, max_iterations = 256;
+    EscapeImage escape = render_escape_image(width, height, max_iterations, -2.2, 1.0, -0.9, 0.9, options.threads);
+    double megapixels = width * static_cast<double>(height) / 1e6;
+    std::cout << "Iteration pass: " << width << "x" << height << ", " << max_iterations << " iter, "
+              << std::fixed << std::setprecision(1) << escape.elapsed_ms << " ms ("
+              << megapixels / (escape.elapsed_ms / 1000.0) << " Mpix/s); AVX2 lookups: "
+              << (PaletteMapper::simd_available() ? "yes" : "no") << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6);
     
-    return info.str();
+    std::cout << std::left << std::setw(28) << "Mode" << std::right << std::setw(8) << "Threads" << std::setw(10) << "Smooth ms"
+              << std::setw(8) << "CDF ms" << std::setw(8) << "Map ms" << std::setw(10) << "Total ms" << std::setw(9) << "Mpix/s"
+              << std::setw(9) << "vs iter" << std::setw(8) << "Colors" << std::setw(7) << "Top%" << std::setw(7) << "Match" << std::endl;
+    auto print_row = [&](const std::string& name, const ColoredImage& image, const char* match) {
+        size_t colors;
+        double top_share;
+        color_spread(image, escape, colors, top_share);
+        std::cout << std::left << std::setw(28) << name << std::right << std::setw(8) << image.threads
+                  << std::fixed << std::setprecision(1) << std::setw(10) << image.smooth_ms << std::setw(8) << image.cdf_ms
+                  << std::setw(8) << image.map_ms << std::setw(10) << image.elapsed_ms
+                  << std::setw(9) << megapixels / (image.elapsed_ms / 1000.0)
+                  << std::setw(8) << 100.0 * image.elapsed_ms / escape.elapsed_ms << "%"
+                  << std::setw(8) << colors << std::setw(7) << 100.0 * top_share << std::setw(7) << match << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+    };
+    
+    print_row("linear bands (get_char)", color_linear_bands(escape), "-");
+    
+    PaletteMapper single(1);
+    ColoredImage reference = single.color(escape, false);
+    print_row("smooth + equalised, scalar", reference, "-");
+    if (PaletteMapper::simd_available()) {
+        ColoredImage simd = single.color(escape, true);
+        print_row("smooth + equalised, AVX2", simd, simd.rgb == reference.rgb ? "yes" : "NO");
+    }
+    PaletteMapper parallel(options.threads);
+    ColoredImage scalar = parallel.color(escape, false);
+    print_row("smooth + equalised, scalar", scalar, scalar.rgb == reference.rgb ? "yes" : "NO");
+    ColoredImage best = parallel.color(escape, true);
+    if (best.simd) print_row("smooth + equalised, AVX2", best, best.rgb == reference.rgb ? "yes" : "NO");
+    
+    if (!options.ppm.empty()) {
+        write_ppm(options.ppm, best);
+        std::cout << "Wrote " << options.ppm << std::endl;
+    }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 2;
+    }
+    
     std::cout << "Mandelbrot Set Benchmark" << std::endl;
     std::cout << "========================" << std::endl;
     
     // Small render for visualization
-    std::cout << "\n1. Visual demonstration (80x40, color):" << std::endl;
-    std::cout << "Rendering colorful Mandelbrot view..." << std::endl;
-    
-    MandelbrotRenderer small_renderer(80, 40, 100);
-    double small_time = small_renderer.render(-2.5, 1.0, -1.25, 1.25, true, false, true);
-    std::cout << "\nTime: " << small_time << " ms" << std::endl;
-    std::cout << "\nPress Enter to continue to benchmark...";
-    std::cin.get();
-    
-    // Different zoom levels for benchmarking
-    std::cout << "\n2. Performance benchmark (different zoom levels):" << std::endl;
+    double small_time = -1.0;
+    if (options.wants("demo")) {
+        std::cout << "\n1. Visual demonstration (80x40, color):" << std::endl;
+        std::cout << "Rendering colorful Mandelbrot view..." << std::endl;
+        
+        MandelbrotRenderer small_renderer(80, 40, 100);
+        small_time = small_renderer.render(-2.5, 1.0, -1.25, 1.25, true, false, true);
+        std::cout << "\nTime: " << small_time << " ms" << std::endl;
+        std::cout << "\nPress Enter to continue to benchmark...";
+        std::cin.get();
+    }
     
     struct ZoomLevel {
         std::string name;
@@ -217,32 +492,67 @@ int main() {
         {"Deep zoom", -0.7463, -0.7453, 0.1102, 0.1112, 200, 500}
     };
     
+    // Different zoom levels for benchmarking
     std::vector<double> zoom_times;
-    for (const auto& zoom : zooms) {
-        std::cout << zoom.name << " (" << zoom.resolution << "x" << zoom.resolution 
-                  << ", " << zoom.iterations << " iter) - ";
-        std::cout.flush();
-        
-        MandelbrotRenderer renderer(zoom.resolution, zoom.resolution, zoom.iterations);
-        double time = renderer.render(zoom.x_min, zoom.x_max, zoom.y_min, zoom.y_max, false);
-        zoom_times.push_back(time);
-        
-        std::cout << "Time: " << time << " ms" << std::endl;
+    if (options.wants("zooms")) {
+        std::cout << "\n2. Performance benchmark (different zoom levels):" << std::endl;
+        for (const auto& zoom : zooms) {
+            std::cout << zoom.name << " (" << zoom.resolution << "x" << zoom.resolution 
+                      << ", " << zoom.iterations << " iter) - ";
+            std::cout.flush();
+            
+            MandelbrotRenderer renderer(zoom.resolution, zoom.resolution, zoom.iterations);
+            double time = renderer.render(zoom.x_min, zoom.x_max, zoom.y_min, zoom.y_max, false);
+            zoom_times.push_back(time);
+            
+            std::cout << "Time: " << time << " ms" << std::endl;
+        }
     }
     
-    std::cout << "\n3. Resolution scaling test:" << std::endl;
     std::vector<int> resolutions = {100, 200, 400, 800};
     std::vector<double> resolution_times;
+    if (options.wants("resolutions")) {
+        std::cout << "\n3. Resolution scaling test:" << std::endl;
+        for (int res : resolutions) {
+            std::cout << res << "x" << res << " resolution - ";
+            std::cout.flush();
+            
+            MandelbrotRenderer renderer(res, res, 100);
+            double time = renderer.render(-2.5, 1.0, -1.25, 1.25, false);
+            resolution_times.push_back(time);
+            
+            std::cout << "Time: " << time << " ms" << std::endl;
+        }
+    }
     
-    for (int res : resolutions) {
-        std::cout << res << "x" << res << " resolution - ";
-        std::cout.flush();
-        
-        MandelbrotRenderer renderer(res, res, 100);
-        double time = renderer.render(-2.5, 1.0, -1.25, 1.25, false);
-        resolution_times.push_back(time);
-        
-        std::cout << "Time: " << time << " ms" << std::endl;
+    if (options.wants("aa")) {
+        std::cout << "\n4. Adaptive anti-aliasing (edge pixels only vs full supersampling):" << std::endl;
+        run_antialiasing(options);
+    }
+    
+    if (options.wants("progressive")) {
+        std::cout << "\n5. Progressive rendering (compute threads feeding a display thread):" << std::endl;
+        run_progressive(options);
+    }
+    
+    if (options.wants("farm")) {
+        std::cout << "\n6. Tile farm (coordinator and worker processes):" << std::endl;
+        run_tile_farm(options);
+    }
+    
+    if (options.wants("scaling")) {
+        std::cout << "\n7. Scaling sweep (time against pixels, breakpoints against cache sizes):" << std::endl;
+        run_scaling(options);
+    }
+    
+    if (options.wants("batch")) {
+        std::cout << "\n8. Batch thumbnail rendering (one shared pool, cost-ordered jobs and bands):" << std::endl;
+        run_batch(options);
+    }
+    
+    if (options.wants("coloring")) {
+        std::cout << "\n9. Smooth, histogram-equalised coloring at 4k (separate from iteration cost):" << std::endl;
+        run_coloring(options);
     }
     
     // Output formatted results for copy-paste
@@ -258,17 +568,20 @@ int main() {
     #define CXXFLAGS "Unknown"
     #endif
     std::cout << "Compiler: g++ " << CXXFLAGS << std::endl;
+    std::cout << "Build: " << build_flavor() << std::endl;
     std::cout << "Date: " << __DATE__ << std::endl;
     
     std::cout << "\nMandelbrot Benchmark Results:" << std::endl;
-    std::cout << "- Full view (200x200, 100 iter): " << zoom_times[0] << " ms" << std::endl;
-    std::cout << "- Zoom 1x (200x200, 150 iter): " << zoom_times[1] << " ms" << std::endl;
-    std::cout << "- Zoom 2x (200x200, 200 iter): " << zoom_times[2] << " ms" << std::endl;
-    std::cout << "- Deep zoom (200x200, 500 iter): " << zoom_times[3] << " ms" << std::endl;
-    std::cout << "- Resolution 100x100: " << resolution_times[0] << " ms" << std::endl;
-    std::cout << "- Resolution 200x200: " << resolution_times[1] << " ms" << std::endl;
-    std::cout << "- Resolution 400x400: " << resolution_times[2] << " ms" << std::endl;
-    std::cout << "- Resolution 800x800: " << resolution_times[3] << " ms" << std::endl;
+    for (size_t i = 0; i < zoom_times.size(); i++) {
+        std::cout << "- " << zooms[i].name << " (" << zooms[i].resolution << "x" << zooms[i].resolution << ", "
+                  << zooms[i].iterations << " iter): " << zoom_times[i] << " ms" << std::endl;
+    }
+    for (size_t i = 0; i < resolution_times.size(); i++) {
+        std::cout << "- Resolution " << resolutions[i] << "x" << resolutions[i] << ": " << resolution_times[i] << " ms" << std::endl;
+    }
+    if (small_time >= 0.0) {
+        std::cout << "- Visual demo time: " << small_time << " ms" << std::endl;
+    }
     
     std::cout << "\nSystem information detected automatically" << std::endl;
     
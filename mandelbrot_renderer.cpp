@@ -0,0 +1,441 @@
+#pragma once
+
+#include "cycle_timer.cpp"
+#include "mpsc_ring.cpp"
+#include "kernel_dispatch.cpp"
+#include "worker_pool.cpp"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <complex>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Sample positions inside a pixel for supersampling
+enum class SamplePattern {
+    Jittered,       // one random point per cell of an n x n grid
+    RotatedGrid     // the n x n grid rotated by atan(1/2), so no two samples share a row or column
+};
+
+// Grey level per pixel (0 inside the set, iterations / max_iterations outside),
+// averaged over the samples taken in that pixel
+struct AntiAliasedImage {
+    int width = 0;
+    int height = 0;
+    std::vector<float> shade;
+    long samples = 0;
+    long refined_pixels = 0;        // pixels that got more than the one base sample
+    double elapsed_ms = 0.0;
+};
+
+// Timeline of one progressive render; all times in ms from the start of the render
+struct ProgressiveStats {
+    double compute_ms = 0.0;            // last row of the finest pass computed
+    double first_preview_ms = -1.0;     // first frame showing the whole 1/8 pass
+    double display_ms = 0.0;            // final frame drawn
+    int frames = 0;
+    size_t max_backlog = 0;             // most finished rows waiting for one frame
+    double mean_backlog = 0.0;
+    long dropped = 0;                   // rows the full ring could not take (redrawn at the end)
+};
+
+namespace render_detail {
+
+// A finished row of one coarse-to-fine pass
+struct RowMessage {
+    int step;       // pass resolution: every step-th pixel of every step-th row
+    int row;
+};
+
+// Deterministic per-sample random number in [0, 1), independent of thread scheduling
+double hash_unit(uint64_t key) {
+    key += 0x9e3779b97f4a7c15ULL; // splitmix64
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return static_cast<double>(key >> 11) / 9007199254740992.0;
+}
+
+// Offset of sample s (of n * n) from the pixel centre, in pixels within [-0.5, 0.5)
+void sample_offset(SamplePattern pattern, int n, int s, uint64_t pixel, uint64_t seed, double& ox, double& oy) {
+    int i = s % n, j = s / n;
+    if (pattern == SamplePattern::Jittered) {
+        uint64_t key = (pixel * n * n + s) * 2 + (seed << 48);
+        ox = (i + hash_unit(key)) / n - 0.5;
+        oy = (j + hash_unit(key + 1)) / n - 0.5;
+        return;
+    }
+    const double cos_a = 2.0 / std::sqrt(5.0), sin_a = 1.0 / std::sqrt(5.0);
+    double gx = (i + 0.5) / n - 0.5, gy = (j + 0.5) / n - 0.5;
+    ox = gx * cos_a - gy * sin_a;
+    oy = gx * sin_a + gy * cos_a;
+    ox -= std::floor(ox + 0.5); // wrap back into the pixel
+    oy -= std::floor(oy + 0.5);
+}
+
+} // namespace render_detail
+
+class MandelbrotRenderer {
+private:
+    int width, height;
+    int max_iterations;
+    
+    HOT_KERNEL int mandelbrot_iterations(std::complex<double> c) {
+        std::complex<double> z = 0;
+        for (int i = 0; i < max_iterations; i++) {
+            if (std::abs(z) > 2.0) return i;
+            z = z * z + c;
+        }
+        return max_iterations;
+    }
+    
+    // As mandelbrot_iterations, also giving |z| three iterations past the escape (0 inside
+    // the set); a bailout of 2 is too small for the smooth count to join up across bands
+    HOT_KERNEL int escape_iterations(std::complex<double> c, float& radius) {
+        std::complex<double> z = 0;
+        for (int i = 0; i < max_iterations; i++) {
+            if (std::abs(z) > 2.0) {
+                for (int k = 0; k < 3; k++) z = z * z + c;
+                radius = static_cast<float>(std::abs(z));
+                return i;
+            }
+            z = z * z + c;
+        }
+        radius = 0.0f;
+        return max_iterations;
+    }
+    
+    std::string get_colored_char(int iterations) {
+        if (iterations >= max_iterations) {
+            return "\033[40m \033[0m"; // Black background for Mandelbrot set
+        }
+        
+        // Color gradients: Blue -> Cyan -> Green -> Yellow -> Red -> Magenta
+        const std::string colors[] = {
+            "\033[44m ", // Blue
+            "\033[46m ", // Cyan  
+            "\033[42m ", // Green
+            "\033[43m ", // Yellow
+            "\033[41m ", // Red
+            "\033[45m "  // Magenta
+        };
+        
+        int color_index = (iterations * 6) / max_iterations;
+        if (color_index >= 6) color_index = 5;
+        
+        return colors[color_index] + "\033[0m";
+    }
+    
+    float shade_of(int iterations) const {
+        return iterations >= max_iterations ? 0.0f : static_cast<float>(iterations) / max_iterations;
+    }
+    
+    // Mean shade of n * n samples in pixel (col, row)
+    float sample_pixel(double x_min, double x_scale, double y_min, double y_scale, int col, int row,
+                       int n, SamplePattern pattern, uint64_t seed) {
+        double sum = 0.0;
+        uint64_t pixel = static_cast<uint64_t>(row) * width + col;
+        for (int s = 0; s < n * n; s++) {
+            double ox, oy;
+            render_detail::sample_offset(pattern, n, s, pixel, seed, ox, oy);
+            std::complex<double> c(x_min + (col + 0.5 + ox) * x_scale, y_min + (row + 0.5 + oy) * y_scale);
+            sum += shade_of(mandelbrot_iterations(c));
+        }
+        return static_cast<float>(sum / (n * n));
+    }
+    
+    char get_char(int iterations) {
+        if (iterations >= max_iterations) return '#';
+        
+        // More detailed character gradient
+        const char chars[] = " .:-=+*#%@";
+        int index = iterations * (sizeof(chars) - 2) / max_iterations;
+        return chars[index];
+    }
+    
+public:
+    MandelbrotRenderer(int w, int h, int max_iter) 
+        : width(w), height(h), max_iterations(max_iter) {}
+    
+    double render(double x_min, double x_max, double y_min, double y_max, 
+                  bool visualize = true, bool progressive = false, bool use_color = false) {
+        if (visualize && progressive) {
+            return render_progressive(x_min, x_max, y_min, y_max, &std::cout, use_color).compute_ms;
+        }
+        
+        CycleTimer& timer = CycleTimer::instance();
+        uint64_t start_ticks = timer.start();
+        
+        if (visualize) {
+            std::cout << "\033[2J\033[H"; // Clear screen
+        }
+        
+        double x_scale = (x_max - x_min) / width;
+        double y_scale = (y_max - y_min) / height;
+        long total_iterations = 0;
+        
+        for (int row = 0; row < height; row++) {
+            double y = y_min + row * y_scale;
+            
+            for (int col = 0; col < width; col++) {
+                double x = x_min + col * x_scale;
+                std::complex<double> c(x, y);
+                
+                int iterations = mandelbrot_iterations(c);
+                total_iterations += iterations;
+                
+                if (visualize) {
+                    if (use_color) {
+                        std::cout << get_colored_char(iterations);
+                    } else {
+                        std::cout << get_char(iterations);
+                    }
+                }
+            }
+            
+            if (visualize) {
+                std::cout << std::endl;
+            }
+        }
+        
+        uint64_t end_ticks = timer.stop();
+        double elapsed_ms = timer.elapsed_ms(start_ticks, end_ticks);
+        keep_result(total_iterations);
+        
+        return elapsed_ms; // Return time in milliseconds
+    }
+    
+    // Iteration counts of the w x h tile at pixel (x0, y0), row-major into out;
+    // the same sample positions as render()
+    void render_tile(double x_min, double x_max, double y_min, double y_max,
+                     int x0, int y0, int w, int h, int32_t* out) {
+        double x_scale = (x_max - x_min) / width;
+        double y_scale = (y_max - y_min) / height;
+        for (int row = 0; row < h; row++) {
+            double y = y_min + (y0 + row) * y_scale;
+            for (int col = 0; col < w; col++) {
+                out[static_cast<size_t>(row) * w + col] =
+                    mandelbrot_iterations(std::complex<double>(x_min + (x0 + col) * x_scale, y));
+            }
+        }
+    }
+    
+    // render_tile plus the escape radius per pixel, for smooth (fractional) iteration counts
+    void render_escape_tile(double x_min, double x_max, double y_min, double y_max,
+                            int x0, int y0, int w, int h, int32_t* out, float* radius) {
+        double x_scale = (x_max - x_min) / width;
+        double y_scale = (y_max - y_min) / height;
+        for (int row = 0; row < h; row++) {
+            double y = y_min + (y0 + row) * y_scale;
+            for (int col = 0; col < w; col++) {
+                size_t i = static_cast<size_t>(row) * w + col;
+                out[i] = escape_iterations(std::complex<double>(x_min + (x0 + col) * x_scale, y), radius[i]);
+            }
+        }
+    }
+    
+    // Compute threads render coarse-to-fine passes (1/8, 1/4, 1/2, full resolution) and
+    // post each finished row to a lock-free ring; a display thread drains the ring once
+    // per frame and draws to out (nullptr: frames are composed but not written).
+    // Compute never waits for the display: a row that does not fit in the ring is
+    // counted as dropped and picked up by a full redraw after the last pass.
+    ProgressiveStats render_progressive(double x_min, double x_max, double y_min, double y_max,
+                                        std::ostream* out, bool use_color = false, int threads = 0,
+                                        double frame_ms = 50.0, size_t ring_capacity = 0) {
+        CycleTimer& timer = CycleTimer::instance();
+        uint64_t start_ticks = timer.start();
+        ProgressiveStats stats;
+        
+        const int steps[4] = {8, 4, 2, 1};
+        std::vector<render_detail::RowMessage> jobs;
+        int preview_rows = 0;
+        for (int step : steps) {
+            for (int row = 0; row < height; row += step) jobs.push_back({step, row});
+            if (step == steps[0]) preview_rows = static_cast<int>(jobs.size());
+        }
+        
+        // Each pixel is computed once, by the first pass whose grid contains it; a popped
+        // message makes its row's pixels of that pass visible to the display thread
+        std::vector<int> iterations(static_cast<size_t>(width) * height, 0);
+        MpscRing<render_detail::RowMessage> ring(ring_capacity ? ring_capacity : jobs.size());
+        std::atomic<bool> done(false);
+        std::atomic<long> dropped(0);
+        
+        std::thread display([&] {
+            std::vector<int> frame(iterations.size(), 0);
+            std::vector<int> level(iterations.size(), 16);     // step that filled the cell
+            int preview_seen = 0;
+            size_t backlog_total = 0;
+            auto fill = [&](int step, int row) {
+                for (int col = 0; col < width; col += step) {
+                    if (step < 8 && row % (step * 2) == 0 && col % (step * 2) == 0) continue;
+                    int value = iterations[static_cast<size_t>(row) * width + col];
+                    // Coarse pixels stand in for the block below and right of them until finer passes arrive
+                    for (int y = row; y < std::min(height, row + step); y++) {
+                        for (int x = col; x < std::min(width, col + step); x++) {
+                            size_t i = static_cast<size_t>(y) * width + x;
+                            if (level[i] < step) continue;
+                            frame[i] = value;
+                            level[i] = step;
+                        }
+                    }
+                }
+            };
+            auto next_frame = std::chrono::steady_clock::now();
+            while (true) {
+                bool finished = done.load(std::memory_order_acquire);
+                size_t backlog = 0;
+                render_detail::RowMessage message;
+                while (ring.try_pop(message)) {
+                    fill(message.step, message.row);
+                    if (message.step == steps[0]) preview_seen++;
+                    backlog++;
+                }
+                if (finished && dropped.load() > 0) {
+                    frame = iterations;
+                    std::fill(level.begin(), level.end(), 1);
+                    preview_seen = preview_rows;
+                }
+                if (backlog > 0 || finished) {
+                    std::stringstream text;
+                    text << "\033[H";
+                    for (int y = 0; y < height; y++) {
+                        for (int x = 0; x < width; x++) {
+                            size_t i = static_cast<size_t>(y) * width + x;
+                            if (level[i] > 8) {
+                                text << ' ';
+                            } else if (use_color) {
+                                text << get_colored_char(frame[i]);
+                            } else {
+                                text << get_char(frame[i]);
+                            }
+                        }
+                        text << '\n';
+                    }
+                    if (out) {
+                        *out << text.str();
+                        out->flush();
+                    }
+                    stats.frames++;
+                    stats.max_backlog = std::max(stats.max_backlog, backlog);
+                    backlog_total += backlog;
+                    if (stats.first_preview_ms < 0.0 && preview_seen >= preview_rows) {
+                        stats.first_preview_ms = timer.elapsed_ms(start_ticks, timer.stop());
+                    }
+                }
+                if (finished) break;
+                next_frame += std::chrono::microseconds(static_cast<long>(frame_ms * 1000.0));
+                std::this_thread::sleep_until(next_frame);
+            }
+            stats.mean_backlog = stats.frames ? static_cast<double>(backlog_total) / stats.frames : 0.0;
+            stats.display_ms = timer.elapsed_ms(start_ticks, timer.stop());
+        });
+        
+        if (out) *out << "\033[2J"; // Clear screen once; frames redraw in place
+        double x_scale = (x_max - x_min) / width;
+        double y_scale = (y_max - y_min) / height;
+        parallel_rows(static_cast<int>(jobs.size()), threads, [&](int job) {
+            int step = jobs[job].step;
+            int row = jobs[job].row;
+            double y = y_min + row * y_scale;
+            for (int col = 0; col < width; col += step) {
+                if (step < 8 && row % (step * 2) == 0 && col % (step * 2) == 0) continue;
+                iterations[static_cast<size_t>(row) * width + col] =
+                    mandelbrot_iterations(std::complex<double>(x_min + col * x_scale, y));
+            }
+            if (!ring.try_push(jobs[job])) dropped++;
+        });
+        stats.compute_ms = timer.elapsed_ms(start_ticks, timer.stop());
+        done.store(true, std::memory_order_release);
+        display.join();
+        stats.dropped = dropped.load();
+        return stats;
+    }
+    
+    // Brute-force anti-aliasing: n * n samples in every pixel
+    AntiAliasedImage render_supersampled(double x_min, double x_max, double y_min, double y_max, int n,
+                                         SamplePattern pattern = SamplePattern::Jittered, int threads = 0,
+                                         uint64_t seed = 1) {
+        CycleTimer& timer = CycleTimer::instance();
+        uint64_t start_ticks = timer.start();
+        
+        AntiAliasedImage image;
+        image.width = width;
+        image.height = height;
+        image.shade.resize(static_cast<size_t>(width) * height);
+        double x_scale = (x_max - x_min) / width;
+        double y_scale = (y_max - y_min) / height;
+        parallel_rows(height, threads, [&](int row) {
+            for (int col = 0; col < width; col++) {
+                image.shade[static_cast<size_t>(row) * width + col] =
+                    sample_pixel(x_min, x_scale, y_min, y_scale, col, row, n, pattern, seed);
+            }
+        });
+        image.samples = static_cast<long>(width) * height * n * n;
+        image.refined_pixels = n > 1 ? static_cast<long>(width) * height : 0;
+        
+        image.elapsed_ms = timer.elapsed_ms(start_ticks, timer.stop());
+        return image;
+    }
+    
+    // Adaptive anti-aliasing: one sample at every pixel centre, then n * n samples only
+    // in pixels whose shade differs from one of their 8 neighbours by more than threshold
+    AntiAliasedImage render_adaptive(double x_min, double x_max, double y_min, double y_max, int n,
+                                     double threshold, SamplePattern pattern = SamplePattern::Jittered,
+                                     int threads = 0, uint64_t seed = 1) {
+        CycleTimer& timer = CycleTimer::instance();
+        uint64_t start_ticks = timer.start();
+        
+        AntiAliasedImage image;
+        image.width = width;
+        image.height = height;
+        double x_scale = (x_max - x_min) / width;
+        double y_scale = (y_max - y_min) / height;
+        
+        // Base pass
+        std::vector<float> base(static_cast<size_t>(width) * height);
+        parallel_rows(height, threads, [&](int row) {
+            double y = y_min + (row + 0.5) * y_scale;
+            for (int col = 0; col < width; col++) {
+                std::complex<double> c(x_min + (col + 0.5) * x_scale, y);
+                base[static_cast<size_t>(row) * width + col] = shade_of(mandelbrot_iterations(c));
+            }
+        });
+        
+        // Edge detection reads only the base buffer, so refinement can write the result freely
+        image.shade = base;
+        std::vector<long> refined_per_row(height, 0);
+        parallel_rows(height, threads, [&](int row) {
+            for (int col = 0; col < width; col++) {
+                float centre = base[static_cast<size_t>(row) * width + col];
+                bool edge = false;
+                for (int dy = -1; dy <= 1 && !edge; dy++) {
+                    int ny = row + dy;
+                    if (ny < 0 || ny >= height) continue;
+                    for (int dx = -1; dx <= 1; dx++) {
+                        int nx = col + dx;
+                        if (nx < 0 || nx >= width) continue;
+                        if (std::fabs(base[static_cast<size_t>(ny) * width + nx] - centre) > threshold) {
+                            edge = true;
+                            break;
+                        }
+                    }
+                }
+                if (!edge) continue;
+                image.shade[static_cast<size_t>(row) * width + col] =
+                    sample_pixel(x_min, x_scale, y_min, y_scale, col, row, n, pattern, seed);
+                refined_per_row[row]++;
+            }
+        });
+        for (long count : refined_per_row) image.refined_pixels += count;
+        image.samples = static_cast<long>(width) * height + image.refined_pixels * n * n;
+        
+        image.elapsed_ms = timer.elapsed_ms(start_ticks, timer.stop());
+        return image;
+    }
+};
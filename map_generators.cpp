@@ -0,0 +1,279 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+
+// Seeded occupancy maps for the WaveFront planner (1 = obstacle, 0 = free).
+// The same seed always gives the same map, so runs on different machines
+// plan over identical layouts.
+
+using OccupancyGrid = std::vector<std::vector<int>>;
+
+struct MapInstance {
+    std::string name;
+    OccupancyGrid grid;
+    int start_x, start_y;
+    int goal_x, goal_y;
+};
+
+namespace mapgen_detail {
+
+OccupancyGrid filled(int width, int height, int value) {
+    return OccupancyGrid(height, std::vector<int>(width, value));
+}
+
+void add_border(OccupancyGrid& grid) {
+    int height = static_cast<int>(grid.size());
+    int width = static_cast<int>(grid[0].size());
+    for (int i = 0; i < height; i++) {
+        grid[i][0] = grid[i][width - 1] = 1;
+    }
+    for (int j = 0; j < width; j++) {
+        grid[0][j] = grid[height - 1][j] = 1;
+    }
+}
+
+// Walls off every free region except the largest one and returns one of its cells
+std::pair<int, int> keep_largest_region(OccupancyGrid& grid) {
+    int height = static_cast<int>(grid.size());
+    int width = static_cast<int>(grid[0].size());
+    std::vector<int> label(static_cast<size_t>(width) * height, -1);
+    std::vector<int> sizes;
+    std::vector<std::pair<int, int>> seeds;
+    std::vector<std::pair<int, int>> stack;
+    
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            if (grid[i][j] != 0 || label[i * width + j] >= 0) continue;
+            int id = static_cast<int>(sizes.size());
+            int count = 0;
+            label[i * width + j] = id;
+            stack.push_back({i, j});
+            while (!stack.empty()) {
+                auto [y, x] = stack.back();
+                stack.pop_back();
+                count++;
+                const int dy[] = {-1, 1, 0, 0};
+                const int dx[] = {0, 0, -1, 1};
+                for (int k = 0; k < 4; k++) {
+                    int ny = y + dy[k], nx = x + dx[k];
+                    if (ny >= 0 && ny < height && nx >= 0 && nx < width &&
+                        grid[ny][nx] == 0 && label[ny * width + nx] < 0) {
+                        label[ny * width + nx] = id;
+                        stack.push_back({ny, nx});
+                    }
+                }
+            }
+            sizes.push_back(count);
+            seeds.push_back({j, i});
+        }
+    }
+    if (sizes.empty()) return {-1, -1};
+    
+    int largest = static_cast<int>(std::max_element(sizes.begin(), sizes.end()) - sizes.begin());
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            if (grid[i][j] == 0 && label[i * width + j] != largest) grid[i][j] = 1;
+        }
+    }
+    return seeds[largest];
+}
+
+// Free cell closest to (x, y) in scan order of growing square rings
+std::pair<int, int> nearest_free(const OccupancyGrid& grid, int x, int y) {
+    int height = static_cast<int>(grid.size());
+    int width = static_cast<int>(grid[0].size());
+    for (int r = 0; r < std::max(width, height); r++) {
+        for (int i = std::max(0, y - r); i <= std::min(height - 1, y + r); i++) {
+            for (int j = std::max(0, x - r); j <= std::min(width - 1, x + r); j++) {
+                if (grid[i][j] == 0) return {j, i};
+            }
+        }
+    }
+    return {x, y};
+}
+
+MapInstance finish(const std::string& name, OccupancyGrid grid, int sx, int sy, int gx, int gy) {
+    auto start = nearest_free(grid, sx, sy);
+    auto goal = nearest_free(grid, gx, gy);
+    return {name, std::move(grid), start.first, start.second, goal.first, goal.second};
+}
+
+} // namespace mapgen_detail
+
+// The planner's original layout: a border plus an obstacle every 4th cell
+MapInstance generate_pillars(int width, int height) {
+    OccupancyGrid grid = mapgen_detail::filled(width, height, 0);
+    mapgen_detail::add_border(grid);
+    for (int i = 2; i < height - 1; i += 4) {
+        for (int j = 2; j < width - 1; j += 4) {
+            grid[i][j] = 1;
+        }
+    }
+    return mapgen_detail::finish("pillars", std::move(grid), 1, 1, width - 2, height - 2);
+}
+
+// Perfect maze (exactly one path between any two cells) from an iterative recursive backtracker.
+// Passages run on odd coordinates, so the useful size is odd.
+MapInstance generate_maze(int width, int height, uint32_t seed) {
+    std::mt19937 rng(seed);
+    OccupancyGrid grid = mapgen_detail::filled(width, height, 1);
+    int cells_x = (width - 1) / 2;
+    int cells_y = (height - 1) / 2;
+    std::vector<char> visited(static_cast<size_t>(cells_x) * cells_y, 0);
+    std::vector<std::pair<int, int>> stack = {{0, 0}};
+    visited[0] = 1;
+    grid[1][1] = 0;
+    
+    const int dx[] = {1, -1, 0, 0};
+    const int dy[] = {0, 0, 1, -1};
+    while (!stack.empty()) {
+        auto [cx, cy] = stack.back();
+        int options[4];
+        int count = 0;
+        for (int k = 0; k < 4; k++) {
+            int nx = cx + dx[k], ny = cy + dy[k];
+            if (nx >= 0 && nx < cells_x && ny >= 0 && ny < cells_y && !visited[ny * cells_x + nx]) {
+                options[count++] = k;
+            }
+        }
+        if (count == 0) {
+            stack.pop_back();
+            continue;
+        }
+        int k = options[std::uniform_int_distribution<int>(0, count - 1)(rng)];
+        int nx = cx + dx[k], ny = cy + dy[k];
+        visited[ny * cells_x + nx] = 1;
+        grid[2 * cy + 1 + dy[k]][2 * cx + 1 + dx[k]] = 0; // knock down the wall between
+        grid[2 * ny + 1][2 * nx + 1] = 0;
+        stack.push_back({nx, ny});
+    }
+    return mapgen_detail::finish("maze", std::move(grid), 1, 1, 2 * cells_x - 1, 2 * cells_y - 1);
+}
+
+// Cellular-automata caves: random fill, then smoothing with the 4-5 rule.
+// Only the largest cave is kept so start and goal are always connected.
+MapInstance generate_caves(int width, int height, uint32_t seed, double fill = 0.45, int iterations = 5) {
+    std::mt19937 rng(seed);
+    std::bernoulli_distribution wall(fill);
+    OccupancyGrid grid = mapgen_detail::filled(width, height, 0);
+    for (auto& row : grid) {
+        for (auto& cell : row) cell = wall(rng) ? 1 : 0;
+    }
+    mapgen_detail::add_border(grid);
+    
+    OccupancyGrid next = grid;
+    for (int it = 0; it < iterations; it++) {
+        for (int i = 1; i < height - 1; i++) {
+            for (int j = 1; j < width - 1; j++) {
+                int walls = 0;
+                for (int di = -1; di <= 1; di++) {
+                    for (int dj = -1; dj <= 1; dj++) {
+                        walls += grid[i + di][j + dj];
+                    }
+                }
+                next[i][j] = walls >= 5 ? 1 : 0;
+            }
+        }
+        grid.swap(next);
+    }
+    mapgen_detail::keep_largest_region(grid);
+    return mapgen_detail::finish("caves", std::move(grid), 1, 1, width - 2, height - 2);
+}
+
+// Independent random obstacles at the given density. From ~30% on the free cells break
+// into pockets, so only the largest one is kept and start and goal are placed in it.
+MapInstance generate_random(int width, int height, uint32_t seed, double density) {
+    std::mt19937 rng(seed);
+    std::bernoulli_distribution wall(density);
+    OccupancyGrid grid = mapgen_detail::filled(width, height, 0);
+    for (auto& row : grid) {
+        for (auto& cell : row) cell = wall(rng) ? 1 : 0;
+    }
+    mapgen_detail::add_border(grid);
+    mapgen_detail::keep_largest_region(grid);
+    return mapgen_detail::finish("random " + std::to_string(static_cast<int>(density * 100 + 0.5)) + "%",
+                                 std::move(grid), 1, 1, width - 2, height - 2);
+}
+
+// Warehouse floor: double-sided shelving racks separated by one-cell picking aisles,
+// cut by cross aisles every block, with a few randomly closed rack gaps
+MapInstance generate_warehouse(int width, int height, uint32_t seed) {
+    std::mt19937 rng(seed);
+    OccupancyGrid grid = mapgen_detail::filled(width, height, 0);
+    mapgen_detail::add_border(grid);
+    
+    const int margin = 3;                      // main corridor along the walls
+    const int block = 12 + static_cast<int>(rng() % 8); // rack length between cross aisles
+    for (int j = margin; j < width - margin; j += 3) {
+        for (int i = margin; i < height - margin; i++) {
+            bool cross_aisle = (i - margin) % (block + 2) >= block;
+            if (!cross_aisle) {
+                grid[i][j] = 1;
+                if (j + 1 < width - margin) grid[i][j + 1] = 1;
+            }
+        }
+    }
+    // Pallets left in some cross aisles
+    std::bernoulli_distribution blocked(0.15);
+    for (int i = margin; i < height - margin; i++) {
+        if ((i - margin) % (block + 2) != block) continue;
+        for (int j = margin + 2; j < width - margin; j += 3) {
+            if (blocked(rng)) grid[i][j] = grid[i + 1][j] = 1;
+        }
+    }
+    return mapgen_detail::finish("warehouse", std::move(grid), 1, 1, width - 2, height - 2);
+}
+
+// Adversarial for path length: a one-cell corridor spiralling from the rim to the centre,
+// so the goal at its end is about width*height/2 steps from the start
+MapInstance generate_spiral(int width, int height) {
+    OccupancyGrid grid = mapgen_detail::filled(width, height, 1);
+    auto interior = [&](int x, int y) { return x >= 1 && x <= width - 2 && y >= 1 && y <= height - 2; };
+    const int dx[] = {1, 0, -1, 0};
+    const int dy[] = {0, 1, 0, -1};
+    int x = 1, y = 1, dir = 0, turns = 0;
+    grid[y][x] = 0;
+    // Carve straight on until the next step would touch the previous lap, then turn right
+    while (turns < 2) {
+        int nx = x + dx[dir], ny = y + dy[dir];
+        int ax = nx + dx[dir], ay = ny + dy[dir];
+        if (interior(nx, ny) && grid[ny][nx] == 1 && !(interior(ax, ay) && grid[ay][ax] == 0)) {
+            x = nx;
+            y = ny;
+            grid[y][x] = 0;
+            turns = 0;
+        } else {
+            dir = (dir + 1) % 4;
+            turns++;
+        }
+    }
+    return mapgen_detail::finish("spiral", std::move(grid), 1, 1, x, y);
+}
+
+// Adversarial for frontier size: no interior obstacles and the goal in the middle,
+// so the wavefront grows as a full diamond
+MapInstance generate_open(int width, int height) {
+    OccupancyGrid grid = mapgen_detail::filled(width, height, 0);
+    mapgen_detail::add_border(grid);
+    return mapgen_detail::finish("open field", std::move(grid), 1, 1, width / 2, height / 2);
+}
+
+// Every map class at one size, in report order
+std::vector<MapInstance> generate_map_suite(int size, uint32_t seed) {
+    std::vector<MapInstance> maps;
+    maps.push_back(generate_pillars(size, size));
+    maps.push_back(generate_maze(size | 1, size | 1, seed));
+    maps.push_back(generate_caves(size, size, seed + 1));
+    for (double density : {0.10, 0.20, 0.30, 0.40}) {
+        maps.push_back(generate_random(size, size, seed + 2, density));
+    }
+    maps.push_back(generate_warehouse(size, size, seed + 3));
+    maps.push_back(generate_spiral(size, size));
+    maps.push_back(generate_open(size, size));
+    return maps;
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include "host_fingerprint.cpp"
+#include "cycle_timer.cpp"
+#include "kernel_dispatch.cpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+// Memory-hierarchy characterisation, so a machine's kernel timings can be read
+// against what its caches and DRAM deliver: STREAM-style bandwidth (McCalpin's
+// copy/scale/add/triad, bytes counted without write-allocate traffic) at working
+// sets sized for L1, L2, the last-level cache and DRAM, and the latency of
+// dependent loads through a random cyclic permutation of cache lines.
+
+enum class StreamKernel { Copy, Scale, Add, Triad };
+enum class MemoryLevel { L1, L2, LLC, DRAM };
+
+const char* stream_kernel_name(StreamKernel kernel) {
+    switch (kernel) {
+        case StreamKernel::Copy: return "Copy";
+        case StreamKernel::Scale: return "Scale";
+        case StreamKernel::Add: return "Add";
+        case StreamKernel::Triad: return "Triad";
+    }
+    return "?";
+}
+
+const char* memory_level_name(MemoryLevel level) {
+    switch (level) {
+        case MemoryLevel::L1: return "L1";
+        case MemoryLevel::L2: return "L2";
+        case MemoryLevel::LLC: return "LLC";
+        case MemoryLevel::DRAM: return "DRAM";
+    }
+    return "?";
+}
+
+namespace membench_detail {
+
+// Bytes read plus written per element, as STREAM counts them
+size_t bytes_per_element(StreamKernel kernel) {
+    return kernel == StreamKernel::Add || kernel == StreamKernel::Triad ? 3 * sizeof(double) : 2 * sizeof(double);
+}
+
+void run_kernel(StreamKernel kernel, double* a, double* b, double* c, size_t n) {
+    const double scalar = 3.0;
+    switch (kernel) {
+        case StreamKernel::Copy:
+            for (size_t i = 0; i < n; i++) c[i] = a[i];
+            break;
+        case StreamKernel::Scale:
+            for (size_t i = 0; i < n; i++) b[i] = scalar * c[i];
+            break;
+        case StreamKernel::Add:
+            for (size_t i = 0; i < n; i++) c[i] = a[i] + b[i];
+            break;
+        case StreamKernel::Triad:
+            for (size_t i = 0; i < n; i++) a[i] = b[i] + scalar * c[i];
+            break;
+    }
+}
+
+struct alignas(64) ChaseNode {
+    ChaseNode* next;
+    char pad[64 - sizeof(ChaseNode*)];
+};
+
+} // namespace membench_detail
+
+// Working set (all arrays together) that fits the given level with room to spare.
+// Per-thread for the private L1 and L2, shared for LLC and DRAM.
+size_t working_set_bytes(MemoryLevel level) {
+    const HostFingerprint& host = get_host_fingerprint();
+    size_t l1 = host.l1d_cache_bytes > 0 ? static_cast<size_t>(host.l1d_cache_bytes) : 32 * 1024;
+    size_t l2 = host.l2_cache_bytes > 0 ? static_cast<size_t>(host.l2_cache_bytes) : 1024 * 1024;
+    size_t l3 = host.l3_cache_bytes > 0 ? static_cast<size_t>(host.l3_cache_bytes) : 8 * l2;
+    size_t memory = host.memory_total_kb > 0 ? static_cast<size_t>(host.memory_total_kb) * 1024 : 4ULL << 30;
+    switch (level) {
+        case MemoryLevel::L1: return l1 / 2;
+        case MemoryLevel::L2: return l2 / 2;
+        case MemoryLevel::LLC: return l3 / 2;
+        case MemoryLevel::DRAM: {
+            size_t cap = std::min<size_t>(memory / 8, 512ULL << 20);
+            return std::max<size_t>(std::min(4 * l3, cap), 64ULL << 20);
+        }
+    }
+    return l1 / 2;
+}
+
+// GB/s of one kernel, best of three timed batches. Each thread first-touches its own
+// arrays, so they sit on its NUMA node; threads start together behind a spin barrier.
+double stream_bandwidth(StreamKernel kernel, size_t bytes_per_thread, int threads, size_t traffic_bytes = 256ULL << 20) {
+    using namespace membench_detail;
+    threads = std::max(1, threads);
+    size_t n = std::max<size_t>(64, bytes_per_thread / (3 * sizeof(double)));
+    size_t per_pass = n * bytes_per_element(kernel);
+    int passes = static_cast<int>(std::max<size_t>(1, traffic_bytes / (per_pass * threads)));
+    CycleTimer& timer = CycleTimer::instance();
+    
+    double best = 0.0;
+    for (int batch = 0; batch < 3; batch++) {
+        std::atomic<int> ready(0);
+        std::atomic<bool> go(false);
+        std::vector<uint64_t> begin(threads), end(threads);
+        auto body = [&](int t) {
+            std::vector<double> a(n, 1.0), b(n, 2.0), c(n, 0.0);
+            run_kernel(kernel, a.data(), b.data(), c.data(), n); // warm the caches and TLB
+            if (++ready == threads) go.store(true, std::memory_order_release);
+            while (!go.load(std::memory_order_acquire)) {}
+            begin[t] = timer.start();
+            kernel_window_begin();
+            for (int p = 0; p < passes; p++) run_kernel(kernel, a.data(), b.data(), c.data(), n);
+            kernel_window_end();
+            end[t] = timer.stop();
+        };
+        std::vector<std::thread> workers;
+        for (int t = 1; t < threads; t++) workers.emplace_back(body, t);
+        body(0);
+        for (auto& w : workers) w.join();
+        
+        uint64_t first = *std::min_element(begin.begin(), begin.end());
+        uint64_t last = *std::max_element(end.begin(), end.end());
+        double seconds = timer.elapsed_ms(first, last) / 1000.0;
+        double gbs = seconds > 0.0 ? static_cast<double>(per_pass) * passes * threads / seconds / 1e9 : 0.0;
+        best = std::max(best, gbs);
+    }
+    return best;
+}
+
+// Nanoseconds per dependent load over a working set of the given size
+double pointer_chase_latency(size_t bytes, size_t loads = 4u << 20) {
+    using namespace membench_detail;
+    size_t count = std::max<size_t>(2, bytes / sizeof(ChaseNode));
+    std::vector<ChaseNode> nodes(count);
+    
+    // Sattolo's shuffle gives a single cycle through every line, in random order
+    std::vector<uint32_t> order(count);
+    for (size_t i = 0; i < count; i++) order[i] = static_cast<uint32_t>(i);
+    std::mt19937_64 rng(12345);
+    for (size_t i = count - 1; i > 0; i--) {
+        std::uniform_int_distribution<size_t> pick(0, i - 1);
+        std::swap(order[i], order[pick(rng)]);
+    }
+    for (size_t i = 0; i < count; i++) nodes[order[i]].next = &nodes[order[(i + 1) % count]];
+    
+    CycleTimer& timer = CycleTimer::instance();
+    ChaseNode* p = &nodes[0];
+    for (size_t i = 0; i < count; i++) p = p->next; // warm-up lap
+    uint64_t start = timer.start();
+    kernel_window_begin();
+    for (size_t i = 0; i < loads; i++) p = p->next;
+    kernel_window_end();
+    uint64_t stop = timer.stop();
+    keep_result(p); // keeps the chain alive
+    return timer.elapsed_ms(start, stop) * 1e6 / loads;
+}
+
+// Full matrix and latency curve, for reading alongside the table columns
+void print_memory_report(int threads) {
+    const MemoryLevel levels[] = {MemoryLevel::L1, MemoryLevel::L2, MemoryLevel::LLC, MemoryLevel::DRAM};
+    const StreamKernel kernels[] = {StreamKernel::Copy, StreamKernel::Scale, StreamKernel::Add, StreamKernel::Triad};
+    
+    std::cout << "\nMemory bandwidth (GB/s, 1 thread / " << threads << " threads):" << std::endl;
+    std::cout << std::left << std::setw(7) << "Level" << std::right << std::setw(11) << "Set";
+    for (StreamKernel kernel : kernels) std::cout << std::setw(16) << stream_kernel_name(kernel);
+    std::cout << std::endl;
+    for (MemoryLevel level : levels) {
+        size_t bytes = working_set_bytes(level);
+        // Private levels scale with the thread count, shared ones are split between threads
+        bool shared = level == MemoryLevel::LLC || level == MemoryLevel::DRAM;
+        size_t per_thread = shared ? bytes / threads : bytes;
+        std::cout << std::left << std::setw(7) << memory_level_name(level) << std::right
+                  << std::setw(11) << format_cache_size(static_cast<long long>(bytes)) << std::fixed << std::setprecision(1);
+        for (StreamKernel kernel : kernels) {
+            double single = stream_bandwidth(kernel, bytes, 1);
+            double multi = stream_bandwidth(kernel, per_thread, threads);
+            std::cout << std::setw(9) << single << " /" << std::setw(5) << multi;
+        }
+        std::cout << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+    }
+    
+    std::cout << "\nLoad-to-use latency (random pointer chase):" << std::endl;
+    size_t largest = working_set_bytes(MemoryLevel::DRAM);
+    for (size_t bytes = 4096; bytes <= largest; bytes *= 2) {
+        double ns = pointer_chase_latency(bytes);
+        std::cout << std::setw(8) << format_cache_size(static_cast<long long>(bytes)) << std::fixed << std::setprecision(2)
+                  << std::setw(9) << ns << " ns " << std::string(std::min(60, static_cast<int>(ns / 2.0) + 1), '#') << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+    }
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+// Replaces the global operator new/delete for the whole program that includes this file.
+// Every thread counts into its own slot, so the hot path is two relaxed stores and no locks.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstdint>
+#include <sys/resource.h>
+
+namespace memory_detail {
+
+struct alignas(64) ThreadSlot {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> deallocations{0};
+    std::atomic<uint64_t> bytes_allocated{0};
+};
+
+const int max_slots = 256;
+const int excluded_slot = max_slots + 1;
+ThreadSlot slots[max_slots + 2];   // max_slots: shared by threads beyond max_slots, excluded_slot: never summed
+std::atomic<int> next_slot{0};
+thread_local int this_slot = -1;
+
+inline ThreadSlot& this_thread_slot() {
+    if (this_slot < 0) {
+        int claimed = next_slot.fetch_add(1, std::memory_order_relaxed);
+        this_slot = claimed < max_slots ? claimed : max_slots;
+    }
+    return slots[this_slot];
+}
+
+inline void bump(std::atomic<uint64_t>& counter, uint64_t delta, bool shared) {
+    if (shared) {
+        counter.fetch_add(delta, std::memory_order_relaxed);
+    } else {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+}
+
+inline void record_alloc(std::size_t size) {
+    ThreadSlot& s = this_thread_slot();
+    bool shared = &s >= &slots[max_slots];
+    bump(s.allocations, 1, shared);
+    bump(s.bytes_allocated, size, shared);
+}
+
+inline void record_free() {
+    ThreadSlot& s = this_thread_slot();
+    bump(s.deallocations, 1, &s >= &slots[max_slots]);
+}
+
+inline void* allocate(std::size_t size) {
+    void* p = std::malloc(size ? size : 1);
+    if (p) record_alloc(size);
+    return p;
+}
+
+inline void* allocate_aligned(std::size_t size, std::size_t alignment) {
+    void* p = nullptr;
+    if (alignment < sizeof(void*)) alignment = sizeof(void*);
+    if (posix_memalign(&p, alignment, size ? size : 1) != 0) return nullptr;
+    record_alloc(size);
+    return p;
+}
+
+inline void release(void* p) {
+    if (!p) return;
+    record_free();
+    std::free(p);
+}
+
+} // namespace memory_detail
+
+void* operator new(std::size_t size) {
+    void* p = memory_detail::allocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) {
+    void* p = memory_detail::allocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return memory_detail::allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return memory_detail::allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    void* p = memory_detail::allocate_aligned(size, static_cast<std::size_t>(alignment));
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    void* p = memory_detail::allocate_aligned(size, static_cast<std::size_t>(alignment));
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { memory_detail::release(p); }
+void operator delete[](void* p) noexcept { memory_detail::release(p); }
+void operator delete(void* p, std::size_t) noexcept { memory_detail::release(p); }
+void operator delete[](void* p, std::size_t) noexcept { memory_detail::release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { memory_detail::release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { memory_detail::release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { memory_detail::release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { memory_detail::release(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { memory_detail::release(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { memory_detail::release(p); }
+
+// Background helpers (e.g. the result uploader) call this so their allocations
+// do not show up in the measurements of whatever case is running meanwhile
+void memory_exclude_this_thread() {
+    memory_detail::this_slot = memory_detail::excluded_slot;
+}
+
+struct MemoryCounters {
+    uint64_t allocations = 0;
+    uint64_t deallocations = 0;
+    uint64_t bytes_allocated = 0;
+};
+
+// Sum over all threads that have ever allocated
+MemoryCounters memory_counters_snapshot() {
+    MemoryCounters total;
+    int used = memory_detail::next_slot.load(std::memory_order_relaxed);
+    if (used > memory_detail::max_slots) used = memory_detail::max_slots;
+    for (int i = 0; i <= used; i++) {
+        if (i == used) i = memory_detail::max_slots; // the shared overflow slot
+        total.allocations += memory_detail::slots[i].allocations.load(std::memory_order_relaxed);
+        total.deallocations += memory_detail::slots[i].deallocations.load(std::memory_order_relaxed);
+        total.bytes_allocated += memory_detail::slots[i].bytes_allocated.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+struct MemoryReport {
+    uint64_t allocations = 0;
+    uint64_t bytes_allocated = 0;
+    long peak_rss_kb = 0;
+    bool peak_is_scoped = false;   // false: process-lifetime peak (the high-water mark could not be reset)
+};
+
+// Measures allocations and the resident-set high-water mark of one benchmark case.
+// On Linux the high-water mark is reset through /proc/self/clear_refs so the peak belongs
+// to the case; elsewhere it falls back to getrusage(), which is the peak of the whole process.
+class MemoryScope {
+private:
+    MemoryCounters start;
+    bool scoped_peak;
+    
+    static bool reset_peak_rss() {
+        #ifdef __linux__
+            std::ofstream clear_refs("/proc/self/clear_refs");
+            if (!clear_refs.is_open()) return false;
+            clear_refs << "5";
+            clear_refs.close();
+            return !clear_refs.fail();
+        #else
+            return false;
+        #endif
+    }
+    
+    static long read_peak_rss_kb() {
+        #ifdef __linux__
+            std::ifstream status("/proc/self/status");
+            std::string line;
+            while (std::getline(status, line)) {
+                if (line.find("VmHWM:") == 0) {
+                    return std::atol(line.substr(6).c_str());
+                }
+            }
+        #endif
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+        #ifdef __APPLE__
+            return usage.ru_maxrss / 1024; // bytes on macOS
+        #else
+            return usage.ru_maxrss;
+        #endif
+    }
+    
+public:
+    MemoryScope() {
+        scoped_peak = reset_peak_rss();
+        start = memory_counters_snapshot();
+    }
+    
+    MemoryReport finish() const {
+        MemoryCounters end = memory_counters_snapshot();
+        MemoryReport report;
+        report.allocations = end.allocations - start.allocations;
+        report.bytes_allocated = end.bytes_allocated - start.bytes_allocated;
+        report.peak_rss_kb = read_peak_rss_kb();
+        report.peak_is_scoped = scoped_peak;
+        return report;
+    }
+};
@@ -0,0 +1,228 @@
+#include "json_writer.cpp"
+#include <iostream>
+#include <string>
+#include <map>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <cctype>
+#include <csignal>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+// Local stand-in for the GitHub Gist API (POST/PATCH/GET /gists), used to test the
+// runner's result sync end to end:
+//   ./mock_gist_server --port=8765 --fail-first=3 &
+//   GIST_API_URL=http://127.0.0.1:8765 ./benchmark_runner
+
+struct MockGist {
+    std::string description;
+    std::string filename;
+    std::string content;
+};
+
+class MockGistServer {
+private:
+    int port;
+    int fail_first;
+    int request_count = 0;
+    int next_id = 1;
+    std::map<std::string, MockGist> gists;
+    
+    struct Request {
+        std::string method;
+        std::string path;
+        std::string headers;
+        std::string body;
+    };
+    
+    static bool read_request(int fd, Request& request) {
+        std::string raw;
+        char buffer[16384];
+        size_t header_end = std::string::npos;
+        size_t content_length = 0;
+        while (true) {
+            if (header_end == std::string::npos) {
+                header_end = raw.find("\r\n\r\n");
+                if (header_end != std::string::npos) {
+                    std::string lower = raw.substr(0, header_end);
+                    for (auto& c : lower) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                    size_t at = lower.find("content-length:");
+                    if (at != std::string::npos) content_length = std::strtoul(lower.c_str() + at + 15, nullptr, 10);
+                    request.headers = raw.substr(0, header_end);
+                }
+            }
+            if (header_end != std::string::npos && raw.size() >= header_end + 4 + content_length) break;
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            raw.append(buffer, static_cast<size_t>(n));
+        }
+        
+        size_t first_space = raw.find(' ');
+        size_t second_space = raw.find(' ', first_space + 1);
+        if (first_space == std::string::npos || second_space == std::string::npos) return false;
+        request.method = raw.substr(0, first_space);
+        request.path = raw.substr(first_space + 1, second_space - first_space - 1);
+        request.body = raw.substr(header_end + 4, content_length);
+        return true;
+    }
+    
+    static void send_response(int fd, int status, const std::string& reason, const std::string& body) {
+        std::string response = "HTTP/1.1 " + std::to_string(status) + " " + reason + "\r\n";
+        response += "Content-Type: application/json\r\n";
+        response += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+        response += "Connection: close\r\n\r\n" + body;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return;
+            sent += static_cast<size_t>(n);
+        }
+    }
+    
+    static std::string message_json(const std::string& message) {
+        JsonWriter json;
+        json.begin_object().key("message").value(message).end_object();
+        return json.str();
+    }
+    
+    std::string gist_json(const std::string& id, const MockGist& gist) const {
+        JsonWriter json;
+        json.begin_object()
+            .key("id").value(id)
+            .key("html_url").value("http://127.0.0.1:" + std::to_string(port) + "/gists/" + id)
+            .key("description").value(gist.description)
+            .key("files").begin_object()
+                .key(gist.filename).begin_object()
+                    .key("filename").value(gist.filename)
+                    .key("content").value(gist.content)
+                .end_object()
+            .end_object()
+        .end_object();
+        return json.str();
+    }
+    
+    // The first key inside "files" is the file name
+    static std::string payload_filename(const std::string& body) {
+        size_t files = body.find("\"files\"");
+        if (files == std::string::npos) return "";
+        size_t quote = body.find('"', body.find('{', files));
+        if (quote == std::string::npos) return "";
+        std::string name;
+        json_detail::read_string(body, quote, name);
+        return name;
+    }
+    
+    void handle(int fd) {
+        Request request;
+        if (!read_request(fd, request)) return;
+        request_count++;
+        std::cout << "[mock] " << request.method << " " << request.path << " (" << request.body.size() << " bytes)";
+        
+        if (request_count <= fail_first) {
+            std::cout << " -> 503 (injected failure " << request_count << "/" << fail_first << ")" << std::endl;
+            send_response(fd, 503, "Service Unavailable", message_json("Service Unavailable (mock)"));
+            return;
+        }
+        
+        std::string id = request.path.size() > 7 && request.path.compare(0, 7, "/gists/") == 0 ? request.path.substr(7) : "";
+        bool authorized = request.headers.find("Authorization: token ") != std::string::npos;
+        
+        if (request.method == "POST" && request.path == "/gists") {
+            MockGist gist;
+            json_find_string(request.body, "description", gist.description);
+            gist.filename = payload_filename(request.body);
+            if (gist.filename.empty() || !json_find_string(request.body, "content", gist.content)) {
+                std::cout << " -> 422" << std::endl;
+                send_response(fd, 422, "Unprocessable Entity", message_json("Validation Failed"));
+                return;
+            }
+            id = "mock" + std::to_string(next_id++);
+            gists[id] = gist;
+            std::cout << " -> 201 created " << id << std::endl;
+            send_response(fd, 201, "Created", gist_json(id, gist));
+        } else if (!id.empty() && gists.count(id) == 0) {
+            std::cout << " -> 404" << std::endl;
+            send_response(fd, 404, "Not Found", message_json("Not Found"));
+        } else if (request.method == "GET" && !id.empty()) {
+            std::cout << " -> 200" << std::endl;
+            send_response(fd, 200, "OK", gist_json(id, gists[id]));
+        } else if (request.method == "PATCH" && !id.empty()) {
+            if (!authorized) {
+                std::cout << " -> 401" << std::endl;
+                send_response(fd, 401, "Unauthorized", message_json("Requires authentication"));
+                return;
+            }
+            MockGist& gist = gists[id];
+            json_find_string(request.body, "description", gist.description);
+            std::string name = payload_filename(request.body);
+            if (!name.empty()) gist.filename = name;
+            json_find_string(request.body, "content", gist.content);
+            std::cout << " -> 200 updated " << id << std::endl;
+            send_response(fd, 200, "OK", gist_json(id, gist));
+        } else {
+            std::cout << " -> 404" << std::endl;
+            send_response(fd, 404, "Not Found", message_json("Not Found"));
+        }
+    }
+    
+public:
+    MockGistServer(int listen_port, int failures) : port(listen_port), fail_first(failures) {}
+    
+    int run() {
+        int server = socket(AF_INET, SOCK_STREAM, 0);
+        if (server < 0) {
+            std::cerr << "socket: " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        int reuse = 1;
+        setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        
+        struct sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(server, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 || listen(server, 16) != 0) {
+            std::cerr << "bind 127.0.0.1:" << port << ": " << std::strerror(errno) << std::endl;
+            close(server);
+            return 1;
+        }
+        
+        std::cout << "Mock Gist API listening on http://127.0.0.1:" << port
+                  << " (failing the first " << fail_first << " requests)" << std::endl;
+        while (true) {
+            int client = accept(server, nullptr, nullptr);
+            if (client < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            handle(client);
+            close(client);
+        }
+        close(server);
+        return 0;
+    }
+};
+
+int main(int argc, char* argv[]) {
+    int port = 8765;
+    int fail_first = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.find("--port=") == 0) {
+            port = std::atoi(arg.c_str() + 7);
+        } else if (arg.find("--fail-first=") == 0) {
+            fail_first = std::atoi(arg.c_str() + 13);
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--port=N] [--fail-first=N]" << std::endl;
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    return MockGistServer(port, fail_first).run();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+// Bounded lock-free queue for many producers and one consumer (Vyukov's bounded
+// queue): each slot carries a sequence number that tells producers whether it is
+// free and the consumer whether it is filled. Neither side ever waits; a push into
+// a full ring fails and the caller decides what to do.
+template <typename T>
+class MpscRing {
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+    
+    std::vector<Slot> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> tail{0};   // next slot to claim, shared by producers
+    alignas(64) size_t head = 0;                // next slot to read, consumer only
+    
+public:
+    // Capacity is rounded up to a power of two
+    explicit MpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        slots = std::vector<Slot>(size);
+        mask = size - 1;
+        for (size_t i = 0; i < size; i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+    
+    size_t capacity() const { return slots.size(); }
+    
+    bool try_push(const T& value) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots[pos & mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            if (sequence == pos) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (sequence < pos) {
+                return false; // the consumer has not freed this slot yet: full
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = value;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer thread only
+    bool try_pop(T& value) {
+        Slot& slot = slots[head & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != head + 1) return false;
+        value = slot.value;
+        slot.sequence.store(head + slots.size(), std::memory_order_release);
+        head++;
+        return true;
+    }
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "cycle_timer.cpp"
+#include "map_generators.cpp"
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+
+// Distance fields for many goals on one map in a single sweep (multi-source BFS,
+// Then et al., "The More the Merrier: Efficient Multi-Source Graph Traversal").
+// Up to 64 goals share a traversal: every cell carries a bit mask of the searches
+// that have seen it and of those whose frontier it is on, so a cell's neighbours are
+// read once per level for all goals together. Same moves as WaveFrontPlanner,
+// including the no-corner-cutting rule for 8-connectivity.
+
+class MultiSourcePlanner {
+private:
+    static constexpr int lanes = 64;       // goals per traversal, one bit each
+    
+    int width, height;
+    int stride;                         // padded row length
+    int connectivity;
+    std::vector<uint8_t> blocked;       // padded by one occupied cell on every side
+    std::vector<uint64_t> seen;
+    std::vector<uint64_t> visit;
+    std::vector<uint64_t> visit_next;
+    std::vector<uint32_t> frontier;
+    std::vector<uint32_t> next_frontier;
+    std::vector<int32_t> distance;      // padded cells, interleaved: all goals of a cell are adjacent
+    int goal_count = 0;
+    long reached_cells = 0;
+    
+    int padded(int x, int y) const {
+        return (y + 1) * stride + x + 1;
+    }
+    
+    // One traversal for goals[first, first + count)
+    void sweep(const std::vector<std::pair<int, int>>& goals, int first, int count) {
+        const int offsets[8] = {-1, 1, -stride, stride, -stride - 1, -stride + 1, stride - 1, stride + 1};
+        std::fill(seen.begin(), seen.end(), 0);
+        std::fill(visit.begin(), visit.end(), 0);
+        std::fill(visit_next.begin(), visit_next.end(), 0);
+        frontier.clear();
+        
+        for (int g = 0; g < count; g++) {
+            int p = padded(goals[first + g].first, goals[first + g].second);
+            if (blocked[p]) continue;
+            uint64_t bit = 1ULL << g;
+            if (visit[p] == 0) frontier.push_back(static_cast<uint32_t>(p));
+            seen[p] |= bit;
+            visit[p] |= bit;
+            distance[static_cast<size_t>(p) * goal_count + first + g] = 0;
+            reached_cells++;
+        }
+        
+        int level = 0;
+        while (!frontier.empty()) {
+            level++;
+            next_frontier.clear();
+            for (uint32_t p : frontier) {
+                uint64_t active = visit[p];
+                for (int i = 0; i < connectivity; i++) {
+                    uint32_t n = p + offsets[i];
+                    if (blocked[n]) continue;
+                    // Diagonal: both orthogonal cells must be free (offsets 4..7 = horizontal + vertical)
+                    if (i >= 4 && (blocked[p + (i % 2 == 0 ? -1 : 1)] || blocked[p + (i < 6 ? -stride : stride)])) continue;
+                    uint64_t fresh = active & ~seen[n];
+                    if (fresh == 0) continue;
+                    if (visit_next[n] == 0) next_frontier.push_back(n);
+                    visit_next[n] |= fresh;
+                    seen[n] |= fresh;
+                    int32_t* cell = &distance[static_cast<size_t>(n) * goal_count + first];
+                    while (fresh) {
+                        cell[__builtin_ctzll(fresh)] = level;
+                        fresh &= fresh - 1;
+                        reached_cells++;
+                    }
+                }
+            }
+            for (uint32_t p : frontier) visit[p] = 0;
+            for (uint32_t n : next_frontier) {
+                visit[n] = visit_next[n];
+                visit_next[n] = 0;
+            }
+            frontier.swap(next_frontier);
+        }
+    }
+    
+public:
+    MultiSourcePlanner(const OccupancyGrid& grid, int neighbours = 4)
+        : width(grid.empty() ? 0 : static_cast<int>(grid[0].size())), height(static_cast<int>(grid.size())),
+          stride(width + 2), connectivity(neighbours == 8 ? 8 : 4) {
+        blocked.assign(static_cast<size_t>(stride) * (height + 2), 1);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) blocked[padded(x, y)] = grid[y][x] != 0;
+        }
+        seen.resize(blocked.size());
+        visit.resize(blocked.size());
+        visit_next.resize(blocked.size());
+    }
+    
+    // Distance fields for every goal, 64 goals per traversal; returns milliseconds
+    double planFields(const std::vector<std::pair<int, int>>& goals) {
+        CycleTimer& timer = CycleTimer::instance();
+        uint64_t start_ticks = timer.start();
+        
+        goal_count = static_cast<int>(goals.size());
+        distance.assign(blocked.size() * goal_count, -1);
+        reached_cells = 0;
+        for (int first = 0; first < goal_count; first += lanes) {
+            sweep(goals, first, std::min(lanes, goal_count - first));
+        }
+        
+        uint64_t end_ticks = timer.stop();
+        return timer.elapsed_ms(start_ticks, end_ticks);
+    }
+    
+    // Steps from (x, y) to goal number goal of the last planFields call, -1 if unreachable
+    int getDistance(int goal, int x, int y) const {
+        return distance[static_cast<size_t>(padded(x, y)) * goal_count + goal];
+    }
+    
+    // The distances of all goals for one cell, goal_count values
+    const int32_t* getCellDistances(int x, int y) const {
+        return &distance[static_cast<size_t>(padded(x, y)) * goal_count];
+    }
+    
+    int getGoalCount() const { return goal_count; }
+    
+    // Cell labels written by the last planFields call, summed over goals
+    long getReachedCells() const { return reached_cells; }
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "benchmark_stats.cpp"
+#include "results_history.cpp"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// Compares the current run against earlier runs of the same host and build and decides
+// per case whether it got faster, slower or did not change. Memory metrics are
+// judged the same way and reported as higher or lower; for bandwidth higher is better.
+// A change has to be significant against the pooled baseline samples and also fall
+// outside the range of the baseline runs' medians: samples within one run share the
+// run's conditions, so the test alone flags an unchanged binary on a different day.
+class RegressionGate {
+private:
+    double threshold_percent;
+    double significance;
+    int baseline_runs;
+    int min_runs;
+    int min_samples;
+    int regressions;
+    
+public:
+    RegressionGate(double threshold = 5.0, double alpha = 0.05, int max_baseline_runs = 10)
+        : threshold_percent(threshold), significance(alpha), baseline_runs(max_baseline_runs),
+          min_runs(3), min_samples(5), regressions(0) {}
+    
+    // Returns the verdict printed for the case; counts gate failures internally
+    std::string evaluate(const ResultsHistory& history, const std::string& host, const std::string& build,
+                         const std::string& case_name, const std::string& metric,
+                         const std::vector<double>& current, bool stable = true) {
+        std::vector<double> baseline = history.collect_samples(host, build, case_name, metric, baseline_runs);
+        std::vector<double> run_medians = history.collect_run_medians(host, build, case_name, metric, baseline_runs);
+        
+        std::cout << std::left << std::setw(20) << case_name << std::setw(15) << metric;
+        if (!stable) {
+            std::cout << "unstable (frequency changed during the run, not gated)" << std::endl;
+            return "unstable";
+        }
+        if (static_cast<int>(run_medians.size()) < min_runs || static_cast<int>(baseline.size()) < min_samples ||
+            static_cast<int>(current.size()) < min_samples) {
+            std::cout << "no baseline (" << run_medians.size() << " baseline runs / " << current.size()
+                      << " current samples, need " << min_runs << " / " << min_samples << ")" << std::endl;
+            return "no baseline";
+        }
+        
+        double base_median = sample_median(run_medians);
+        double curr_median = sample_median(current);
+        double lowest = *std::min_element(run_medians.begin(), run_medians.end());
+        double highest = *std::max_element(run_medians.begin(), run_medians.end());
+        bool outside_runs = curr_median < lowest || curr_median > highest;
+        double spread_percent = base_median > 0.0 ?
+            std::max(highest - base_median, base_median - lowest) / base_median * 100.0 : 0.0;
+        double change_percent = base_median > 0.0 ? (curr_median / base_median - 1.0) * 100.0 : 0.0;
+        MannWhitneyResult test = mann_whitney_u(current, baseline);
+        
+        // Deterministic metrics (allocation counts) have no spread; any difference is real
+        if (sample_stddev(baseline) == 0.0 && sample_stddev(current) == 0.0) {
+            test.p_value = curr_median == base_median ? 1.0 : 0.0;
+        }
+        
+        bool is_time = metric.find("time") == 0;
+        bool higher_is_better = metric.find("bandwidth") == 0;
+        std::string worse = is_time ? "slower" : (higher_is_better ? "lower" : "higher");
+        std::string better = is_time ? "faster" : (higher_is_better ? "higher" : "lower");
+        
+        std::string verdict = "no change";
+        if (test.p_value < significance && outside_runs) {
+            verdict = (change_percent > 0.0) != higher_is_better ? worse : better;
+        }
+        
+        bool failed = verdict == worse && std::fabs(change_percent) > threshold_percent;
+        if (failed) regressions++;
+        
+        std::cout << std::setw(10) << verdict
+                  << std::right << std::fixed << std::setprecision(3)
+                  << " baseline " << std::setw(10) << base_median
+                  << "  current " << std::setw(10) << curr_median
+                  << "  " << std::showpos << std::setprecision(1) << change_percent << "%" << std::noshowpos
+                  << "  p=" << std::setprecision(4) << test.p_value
+                  << "  runs +-" << std::setprecision(1) << spread_percent << "%"
+                  << (failed ? "  REGRESSION" : "") << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+        return verdict;
+    }
+    
+    int get_regressions() const {
+        return regressions;
+    }
+    
+    double get_threshold() const {
+        return threshold_percent;
+    }
+};
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "benchmark_stats.cpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <ctime>
+
+// One line of the history file: every sample of one metric for one case in one run.
+struct HistoryRecord {
+    std::string date;
+    std::string host;
+    std::string machine;
+    std::string build;          // compiler flags and build flavor; empty in files from before it was recorded
+    std::string case_name;
+    std::string metric;
+    std::vector<double> samples;
+};
+
+// Machine-readable companion to benchmark_results.md.
+// The markdown table keeps one number per case, the history keeps every repeated sample
+// so later runs can be compared statistically against earlier ones on the same host and
+// build: -O0, -O2 and PGO builds of one host are different baselines.
+class ResultsHistory {
+private:
+    std::string history_file;
+    std::vector<HistoryRecord> records;
+    
+    std::string get_current_datetime() {
+        time_t rawtime;
+        struct tm * timeinfo;
+        char buffer[80];
+        
+        time(&rawtime);
+        timeinfo = localtime(&rawtime);
+        strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", timeinfo);
+        return std::string(buffer);
+    }
+    
+    static std::string sanitize(const std::string& field) {
+        std::string clean = field;
+        for (auto& c : clean) {
+            if (c == '\t' || c == '\n' || c == '\r') c = ' ';
+        }
+        return clean;
+    }
+    
+    static std::vector<std::string> split(const std::string& line, char sep) {
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, sep)) {
+            fields.push_back(field);
+        }
+        return fields;
+    }
+    
+public:
+    ResultsHistory(const std::string& filename = "benchmark_history.tsv")
+        : history_file(filename) {}
+    
+    bool load() {
+        records.clear();
+        std::ifstream file(history_file);
+        if (!file.is_open()) return false;
+        
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            
+            std::vector<std::string> fields = split(line, '\t');
+            // Six fields before the build column was added
+            if (fields.size() != 6 && fields.size() != 7) continue;
+            bool has_build = fields.size() == 7;
+            
+            HistoryRecord record;
+            record.date = fields[0];
+            record.host = fields[1];
+            record.machine = fields[2];
+            record.build = has_build ? fields[3] : "";
+            record.case_name = fields[has_build ? 4 : 3];
+            record.metric = fields[has_build ? 5 : 4];
+            for (const auto& value : split(fields[has_build ? 6 : 5], ',')) {
+                try {
+                    record.samples.push_back(std::stod(value));
+                } catch (const std::exception&) {
+                    // Skip corrupt values, keep the rest of the record
+                }
+            }
+            if (!record.samples.empty()) {
+                records.push_back(record);
+            }
+        }
+        return true;
+    }
+    
+    // Samples of the most recent max_runs records matching host, build, case and metric,
+    // or of the earliest ones (a fixed reference that later runs do not move)
+    std::vector<double> collect_samples(const std::string& host, const std::string& build, const std::string& case_name,
+                                        const std::string& metric, int max_runs = 10,
+                                        bool earliest = false) const {
+        std::vector<double> samples;
+        int runs = 0;
+        auto matches = [&](const HistoryRecord& record) {
+            if (runs >= max_runs || record.host != host || record.build != build ||
+                record.case_name != case_name || record.metric != metric) return;
+            samples.insert(samples.end(), record.samples.begin(), record.samples.end());
+            runs++;
+        };
+        if (earliest) {
+            for (const auto& record : records) matches(record);
+        } else {
+            for (auto it = records.rbegin(); it != records.rend(); ++it) matches(*it);
+        }
+        return samples;
+    }
+    
+    // Median of each of the most recent max_runs matching records, newest first; the
+    // spread between runs, unlike the spread within one, includes what changes from
+    // run to run (placement, frequency, other load)
+    std::vector<double> collect_run_medians(const std::string& host, const std::string& build,
+                                            const std::string& case_name, const std::string& metric,
+                                            int max_runs = 10) const {
+        std::vector<double> medians;
+        for (auto it = records.rbegin(); it != records.rend() && static_cast<int>(medians.size()) < max_runs; ++it) {
+            if (it->host != host || it->build != build || it->case_name != case_name ||
+                it->metric != metric || it->samples.empty()) continue;
+            medians.push_back(sample_median(it->samples));
+        }
+        return medians;
+    }
+    
+    // Host id for a machine name or host id among the records of one build, the most
+    // recent match; an empty name picks the host of the build's oldest record. Empty if
+    // nothing matches.
+    std::string find_host(const std::string& name, const std::string& build) const {
+        if (name.empty()) {
+            for (const auto& record : records) {
+                if (record.build == build) return record.host;
+            }
+            return "";
+        }
+        for (auto it = records.rbegin(); it != records.rend(); ++it) {
+            if (it->build == build && (it->host == name || it->machine == name)) return it->host;
+        }
+        return "";
+    }
+    
+    // Machine name the host's first run of the build was logged under
+    std::string machine_of(const std::string& host, const std::string& build) const {
+        for (const auto& record : records) {
+            if (record.host == host && record.build == build) return record.machine;
+        }
+        return "";
+    }
+    
+    bool append(const std::string& host, const std::string& machine, const std::string& build, const std::string& case_name,
+                const std::string& metric, const std::vector<double>& samples) {
+        bool is_new = !std::ifstream(history_file).good();
+        std::ofstream file(history_file, std::ios::app);
+        if (!file.is_open()) {
+            std::cout << "Error: cannot write " << history_file << std::endl;
+            return false;
+        }
+        if (is_new) {
+            file << "# date\thost\tmachine\tbuild\tcase\tmetric\tsamples\n";
+        }
+        
+        HistoryRecord record = {get_current_datetime(), sanitize(host), sanitize(machine), sanitize(build),
+                                sanitize(case_name), sanitize(metric), samples};
+        file << record.date << "\t" << record.host << "\t" << record.machine << "\t" << record.build << "\t"
+             << record.case_name << "\t" << record.metric << "\t";
+        file.precision(9);
+        for (size_t i = 0; i < samples.size(); i++) {
+            if (i > 0) file << ",";
+            file << samples[i];
+        }
+        file << "\n";
+        records.push_back(record);
+        return true;
+    }
+    
+    const std::vector<HistoryRecord>& get_records() const {
+        return records;
+    }
+    
+    std::string get_filename() const {
+        return history_file;
+    }
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+
+// The Markdown results table shared by every machine. Columns are identified by
+// name, so a table written by an older runner (fewer benchmark columns) or a newer
+// one (more) can be merged: the header is the union of both, in first-seen order,
+// and cells a row does not have are shown as "-".
+
+class ResultsTable {
+private:
+    std::vector<std::string> columns;
+    std::vector<std::vector<std::string>> rows;     // cells in column order
+    
+    static std::vector<std::string> split_cells(const std::string& line) {
+        std::vector<std::string> cells;
+        std::string cell;
+        std::istringstream parts(line.substr(1)); // skip the leading '|'
+        while (std::getline(parts, cell, '|')) {
+            size_t begin = cell.find_first_not_of(' ');
+            size_t end = cell.find_last_not_of(' ');
+            cells.push_back(begin == std::string::npos ? "" : cell.substr(begin, end - begin + 1));
+        }
+        return cells;
+    }
+    
+    int find_column(const std::string& name) const {
+        for (size_t i = 0; i < columns.size(); i++) {
+            if (columns[i] == name) return static_cast<int>(i);
+        }
+        return -1;
+    }
+    
+    int add_column(const std::string& name) {
+        int index = find_column(name);
+        if (index >= 0) return index;
+        columns.push_back(name);
+        for (auto& row : rows) row.push_back("-");
+        return static_cast<int>(columns.size()) - 1;
+    }
+    
+public:
+    static const std::vector<std::string>& fixed_columns() {
+        static const std::vector<std::string> names = {"Date", "Machine", "OS", "CPU", "Memory", "Compiler"};
+        return names;
+    }
+    
+    ResultsTable() : columns(fixed_columns()) {}
+    
+    // A row under the header; the title, header and separator lines are not rows
+    static bool is_data_row(const std::string& line) {
+        return line.size() > 2 && line[0] == '|' && line.find("| Date |") != 0 && line.find("|---") != 0;
+    }
+    
+    // Reads the table out of a results file; false if it has no table header
+    bool parse(const std::string& markdown) {
+        std::vector<std::string> header;
+        std::istringstream lines(markdown);
+        std::string line;
+        while (std::getline(lines, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.find("| Date |") == 0) {
+                header = split_cells(line);
+                for (const auto& name : header) add_column(name);
+            } else if (!header.empty() && is_data_row(line)) {
+                std::vector<std::string> cells = split_cells(line);
+                std::vector<std::string> row(columns.size(), "-");
+                for (size_t i = 0; i < cells.size() && i < header.size(); i++) {
+                    row[find_column(header[i])] = cells[i];
+                }
+                add_row(row);
+            }
+        }
+        return !header.empty();
+    }
+    
+    // Cells by column name; unknown names become new columns
+    void add_row(const std::vector<std::pair<std::string, std::string>>& cells) {
+        std::vector<std::string> row(columns.size(), "-");
+        for (const auto& cell : cells) {
+            int index = add_column(cell.first);
+            row.resize(columns.size(), "-");
+            row[index] = cell.second;
+        }
+        add_row(row);
+    }
+    
+    void add_row(const std::vector<std::string>& row) {
+        if (std::find(rows.begin(), rows.end(), row) == rows.end()) rows.push_back(row);
+    }
+    
+    // Rows of other that this table does not have yet
+    void merge(const ResultsTable& other) {
+        for (const auto& name : other.columns) add_column(name);
+        for (const auto& other_row : other.rows) {
+            std::vector<std::string> row(columns.size(), "-");
+            for (size_t i = 0; i < other.columns.size(); i++) row[find_column(other.columns[i])] = other_row[i];
+            add_row(row);
+        }
+    }
+    
+    size_t row_count() const { return rows.size(); }
+    
+    // Every row's cell of a column, "-" where a row has none; empty if there is no such column
+    std::vector<std::string> column(const std::string& name) const {
+        std::vector<std::string> cells;
+        int index = find_column(name);
+        if (index < 0) return cells;
+        for (const auto& row : rows) cells.push_back(row[index]);
+        return cells;
+    }
+    
+    // Title, header, separator and the rows in date order
+    std::string str() const {
+        std::vector<std::vector<std::string>> sorted = rows;
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](const std::vector<std::string>& a, const std::vector<std::string>& b) { return a[0] < b[0]; });
+        std::stringstream out;
+        out << "# Benchmark Results\n\n|";
+        for (const auto& name : columns) out << " " << name << " |";
+        out << "\n|";
+        for (const auto& name : columns) out << std::string(name.size() + 2, '-') << "|";
+        out << "\n";
+        for (const auto& row : sorted) {
+            out << "|";
+            for (const auto& cell : row) out << " " << cell << " |";
+            out << "\n";
+        }
+        return out.str();
+    }
+};
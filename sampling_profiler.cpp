@@ -0,0 +1,229 @@
+#pragma once
+
+#include "cycle_timer.cpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <cstring>
+#include <cerrno>
+#include <cctype>
+#include <algorithm>
+#include <csignal>
+#include <ctime>
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+// In-process CPU sampling profiler for machines where perf is not available.
+// SIGPROF fires on consumed CPU time; the handler only copies a backtrace into a
+// preallocated slot, symbolization happens after the case has finished.
+// Symbols come from dladdr(), so the binary needs -rdynamic.
+
+namespace profiler_detail {
+
+const int max_depth = 64;
+
+struct Sample {
+    int depth;
+    void* frames[max_depth];
+};
+
+Sample* samples = nullptr;
+int sample_capacity = 0;
+std::atomic<int> sample_count{0};
+std::atomic<int> dropped{0};
+std::atomic<uint64_t> handler_ticks{0};
+std::atomic<bool> active{false};
+
+void on_sigprof(int) {
+    if (!active.load(std::memory_order_relaxed)) return;
+    int saved_errno = errno;
+    uint64_t begin = CycleTimer::instance().start();
+    
+    int index = sample_count.fetch_add(1, std::memory_order_relaxed);
+    if (index < sample_capacity) {
+        samples[index].depth = backtrace(samples[index].frames, max_depth);
+    } else {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    handler_ticks.fetch_add(CycleTimer::instance().stop() - begin, std::memory_order_relaxed);
+    errno = saved_errno;
+}
+
+std::string symbolize(void* address) {
+    Dl_info info;
+    if (dladdr(address, &info) && info.dli_sname) {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        std::string name = status == 0 && demangled ? demangled : info.dli_sname;
+        std::free(demangled);
+        return name;
+    }
+    std::stringstream fallback;
+    if (dladdr(address, &info) && info.dli_fname) {
+        const char* base = std::strrchr(info.dli_fname, '/');
+        fallback << (base ? base + 1 : info.dli_fname) << "+0x"
+                 << std::hex << (reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(info.dli_fbase));
+    } else {
+        fallback << address;
+    }
+    return fallback.str();
+}
+
+// Folded-stack frames may not contain the ';' separator; the count follows the last space
+std::string folded_frame(const std::string& name) {
+    std::string clean = name;
+    for (auto& c : clean) {
+        if (c == ';' || c == '\n') c = '_';
+    }
+    return clean;
+}
+
+} // namespace profiler_detail
+
+struct ProfileSummary {
+    int samples = 0;
+    int dropped = 0;
+    double wall_ms = 0.0;
+    double handler_ms = 0.0;
+    double overhead_percent = 0.0;
+    std::string output_file;
+};
+
+class SamplingProfiler {
+private:
+    int frequency_hz;
+    std::string output_dir;
+    std::vector<profiler_detail::Sample> storage;
+    uint64_t start_ticks;
+    struct sigaction previous_action;
+    #ifdef __linux__
+    timer_t timer_id;
+    #endif
+    
+    void arm(long interval_us) {
+        #ifdef __linux__
+            struct itimerspec spec;
+            spec.it_interval.tv_sec = interval_us / 1000000;
+            spec.it_interval.tv_nsec = (interval_us % 1000000) * 1000;
+            spec.it_value = spec.it_interval;
+            timer_settime(timer_id, 0, &spec, nullptr);
+        #else
+            struct itimerval spec;
+            spec.it_interval.tv_sec = interval_us / 1000000;
+            spec.it_interval.tv_usec = interval_us % 1000000;
+            spec.it_value = spec.it_interval;
+            setitimer(ITIMER_PROF, &spec, nullptr);
+        #endif
+    }
+    
+    static std::string file_name_for(const std::string& case_name) {
+        std::string name;
+        for (char c : case_name) {
+            name += std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::tolower(c)) : '_';
+        }
+        return name + ".folded";
+    }
+    
+public:
+    SamplingProfiler(int hz = 999, const std::string& directory = "profiles", int max_samples = 100000)
+        : frequency_hz(hz), output_dir(directory), storage(max_samples), start_ticks(0) {
+        profiler_detail::samples = storage.data();
+        profiler_detail::sample_capacity = max_samples;
+        
+        // backtrace() loads libgcc on first use, which must not happen inside the signal handler
+        void* warmup[4];
+        backtrace(warmup, 4);
+        
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_handler = profiler_detail::on_sigprof;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGPROF, &action, &previous_action);
+        
+        #ifdef __linux__
+            struct sigevent event;
+            std::memset(&event, 0, sizeof(event));
+            event.sigev_notify = SIGEV_SIGNAL;
+            event.sigev_signo = SIGPROF;
+            timer_create(CLOCK_PROCESS_CPUTIME_ID, &event, &timer_id);
+        #endif
+        
+        mkdir(output_dir.c_str(), 0755);
+    }
+    
+    ~SamplingProfiler() {
+        arm(0);
+        #ifdef __linux__
+            timer_delete(timer_id);
+        #endif
+        sigaction(SIGPROF, &previous_action, nullptr);
+        profiler_detail::samples = nullptr;
+        profiler_detail::sample_capacity = 0;
+    }
+    
+    SamplingProfiler(const SamplingProfiler&) = delete;
+    SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+    
+    int get_frequency() const {
+        return frequency_hz;
+    }
+    
+    void start() {
+        profiler_detail::sample_count.store(0);
+        profiler_detail::dropped.store(0);
+        profiler_detail::handler_ticks.store(0);
+        start_ticks = CycleTimer::instance().start();
+        profiler_detail::active.store(true);
+        arm(1000000L / frequency_hz);
+    }
+    
+    // Stops sampling and writes <output_dir>/<case>.folded for flamegraph.pl / speedscope / inferno
+    ProfileSummary stop(const std::string& case_name) {
+        arm(0);
+        profiler_detail::active.store(false);
+        CycleTimer& timer = CycleTimer::instance();
+        
+        ProfileSummary summary;
+        summary.wall_ms = timer.elapsed_ms(start_ticks, timer.stop());
+        summary.samples = std::min(profiler_detail::sample_count.load(), profiler_detail::sample_capacity);
+        summary.dropped = profiler_detail::dropped.load();
+        summary.handler_ms = timer.ticks_to_ns(profiler_detail::handler_ticks.load()) / 1e6;
+        if (summary.wall_ms > 0.0) {
+            summary.overhead_percent = summary.handler_ms / summary.wall_ms * 100.0;
+        }
+        
+        // Frame 0 is the handler, frame 1 the signal trampoline
+        std::map<void*, std::string> symbols;
+        std::map<std::string, int> stacks;
+        for (int i = 0; i < summary.samples; i++) {
+            const profiler_detail::Sample& sample = storage[i];
+            std::string stack;
+            for (int f = sample.depth - 1; f >= 2; f--) {
+                void* address = sample.frames[f];
+                auto it = symbols.find(address);
+                if (it == symbols.end()) {
+                    it = symbols.insert({address, profiler_detail::folded_frame(profiler_detail::symbolize(address))}).first;
+                }
+                if (!stack.empty()) stack += ";";
+                stack += it->second;
+            }
+            if (!stack.empty()) stacks[stack]++;
+        }
+        
+        summary.output_file = output_dir + "/" + file_name_for(case_name);
+        std::ofstream file(summary.output_file);
+        for (const auto& entry : stacks) {
+            file << entry.first << " " << entry.second << "\n";
+        }
+        return summary;
+    }
+};
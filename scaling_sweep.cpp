@@ -0,0 +1,227 @@
+#pragma once
+
+#include "host_fingerprint.cpp"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+
+// Runs one case over a geometric series of problem sizes and fits how the time
+// grows: a least-squares power law on log-log axes for the whole sweep, and one per
+// segment between breakpoints. A breakpoint is where the cost per element jumps and
+// stays up, which for these kernels usually means the working set has just left a
+// cache level, so each one is matched against the host's cache sizes.
+
+struct SweepCase {
+    std::string name;
+    std::function<double(int)> run;         // milliseconds for one run at this size
+    std::function<double(int)> elements;    // cells or pixels processed at this size
+    std::function<double(int)> bytes;       // working set at this size
+};
+
+struct SweepPoint {
+    int size;
+    double elements;
+    double bytes;
+    double time_ms;         // fastest of the repeats
+    double ns_per_element;
+};
+
+// time_ms = coefficient * elements^exponent over points [first, last]
+struct PowerFit {
+    size_t first = 0, last = 0;
+    double exponent = 0.0;
+    double coefficient = 0.0;
+    double r_squared = 0.0;
+};
+
+struct SweepBreakpoint {
+    size_t index;               // first point after the jump
+    double cost_ratio;          // its cost per element over the segment before
+    std::string cache_level;    // empty when no cache size is near
+    long long cache_bytes;
+};
+
+struct SweepAnalysis {
+    PowerFit overall;
+    std::vector<PowerFit> segments;
+    std::vector<SweepBreakpoint> breakpoints;
+    double median_ns_per_element = 0.0;
+};
+
+// first, first * ratio, ... up to last, rounded and without duplicates
+std::vector<int> geometric_sizes(int first, int last, double ratio) {
+    std::vector<int> sizes;
+    for (double size = first; size <= last * 1.0001; size *= ratio) {
+        int rounded = static_cast<int>(std::lround(size));
+        if (sizes.empty() || rounded != sizes.back()) sizes.push_back(rounded);
+    }
+    return sizes;
+}
+
+std::vector<SweepPoint> run_sweep(const SweepCase& sweep, const std::vector<int>& sizes, int repeats) {
+    std::vector<SweepPoint> points;
+    for (int size : sizes) {
+        double best = -1.0;
+        for (int r = 0; r < std::max(1, repeats); r++) {
+            double time = sweep.run(size);
+            if (best < 0.0 || time < best) best = time;
+        }
+        double elements = sweep.elements(size);
+        points.push_back({size, elements, sweep.bytes(size), best, best * 1e6 / elements});
+    }
+    return points;
+}
+
+// Least squares of log(time) against log(elements)
+PowerFit fit_power_law(const std::vector<SweepPoint>& points, size_t first, size_t last) {
+    PowerFit fit;
+    fit.first = first;
+    fit.last = last;
+    size_t n = last - first + 1;
+    if (last >= points.size() || n < 2) return fit;
+    
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    for (size_t i = first; i <= last; i++) {
+        double x = std::log(points[i].elements);
+        double y = std::log(std::max(points[i].time_ms, 1e-9));
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    double denominator = n * sxx - sx * sx;
+    if (denominator == 0.0) return fit;
+    fit.exponent = (n * sxy - sx * sy) / denominator;
+    double intercept = (sy - fit.exponent * sx) / n;
+    fit.coefficient = std::exp(intercept);
+    
+    double mean_y = sy / n;
+    double total = 0.0, residual = 0.0;
+    for (size_t i = first; i <= last; i++) {
+        double x = std::log(points[i].elements);
+        double y = std::log(std::max(points[i].time_ms, 1e-9));
+        total += (y - mean_y) * (y - mean_y);
+        residual += (y - intercept - fit.exponent * x) * (y - intercept - fit.exponent * x);
+    }
+    fit.r_squared = total > 0.0 ? 1.0 - residual / total : 1.0;
+    return fit;
+}
+
+namespace sweep_detail {
+
+double median_cost(const std::vector<SweepPoint>& points, size_t first, size_t last) {
+    std::vector<double> costs;
+    for (size_t i = first; i <= last; i++) costs.push_back(points[i].ns_per_element);
+    std::sort(costs.begin(), costs.end());
+    size_t mid = costs.size() / 2;
+    return costs.size() % 2 == 0 ? (costs[mid - 1] + costs[mid]) / 2.0 : costs[mid];
+}
+
+// The cache level whose size lies closest to the jump, within a factor of two of
+// the working sets on either side of it (associativity and other data blur the edge);
+// levels an earlier breakpoint already took are skipped
+void match_cache(SweepBreakpoint& breakpoint, double bytes_before, double bytes_after,
+                 const std::vector<SweepBreakpoint>& earlier) {
+    const HostFingerprint& host = get_host_fingerprint();
+    const std::pair<const char*, long long> levels[] = {
+        {"L1d", host.l1d_cache_bytes}, {"L2", host.l2_cache_bytes}, {"L3", host.l3_cache_bytes}
+    };
+    double midpoint = std::sqrt(bytes_before * bytes_after);
+    double best_distance = 0.0;
+    breakpoint.cache_bytes = 0;
+    for (const auto& level : levels) {
+        if (level.second <= 0) continue;
+        bool taken = std::any_of(earlier.begin(), earlier.end(),
+                                 [&](const SweepBreakpoint& b) { return b.cache_level == level.first; });
+        if (taken) continue;
+        double size = static_cast<double>(level.second);
+        if (size < bytes_before / 2.0 || size > bytes_after * 2.0) continue;
+        double distance = std::fabs(std::log(size / midpoint));
+        if (breakpoint.cache_bytes == 0 || distance < best_distance) {
+            best_distance = distance;
+            breakpoint.cache_level = level.first;
+            breakpoint.cache_bytes = level.second;
+        }
+    }
+}
+
+} // namespace sweep_detail
+
+// A point starts a new segment when its cost per element, and the next point's,
+// exceed the current segment's median cost by jump and the next point stays within
+// jump of it, so a new plateau has formed. Every segment keeps at least min_points
+// points, which stops a steady rise from opening a breakpoint at each step; segments
+// are fitted separately.
+SweepAnalysis analyze_sweep(const std::vector<SweepPoint>& points, double jump = 1.3, size_t min_points = 2) {
+    using namespace sweep_detail;
+    SweepAnalysis analysis;
+    if (points.empty()) return analysis;
+    analysis.overall = fit_power_law(points, 0, points.size() - 1);
+    analysis.median_ns_per_element = median_cost(points, 0, points.size() - 1);
+    
+    min_points = std::max<size_t>(1, min_points);
+    size_t segment_start = 0;
+    for (size_t i = segment_start + min_points; i + min_points <= points.size(); i++) {
+        if (i - segment_start < min_points) continue;
+        double baseline = median_cost(points, segment_start, i - 1);
+        double cost = points[i].ns_per_element;
+        bool jumped = cost > jump * baseline;
+        bool plateau = true;
+        for (size_t j = i + 1; j < i + min_points; j++) {
+            plateau = plateau && points[j].ns_per_element > jump * baseline && points[j].ns_per_element <= jump * cost;
+        }
+        if (!jumped || !plateau) continue;
+        
+        SweepBreakpoint breakpoint = {i, cost / baseline, "", 0};
+        match_cache(breakpoint, points[i - 1].bytes, points[i].bytes, analysis.breakpoints);
+        analysis.breakpoints.push_back(breakpoint);
+        analysis.segments.push_back(fit_power_law(points, segment_start, i - 1));
+        segment_start = i;
+    }
+    analysis.segments.push_back(fit_power_law(points, segment_start, points.size() - 1));
+    return analysis;
+}
+
+void print_sweep(const std::string& size_label, const std::vector<SweepPoint>& points, const SweepAnalysis& analysis) {
+    std::cout << std::left << std::setw(10) << size_label << std::right << std::setw(12) << "Elements"
+              << std::setw(12) << "Working set" << std::setw(12) << "Time ms" << std::setw(12) << "ns/elem" << std::endl;
+    size_t next_break = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        const SweepPoint& p = points[i];
+        std::cout << std::left << std::setw(10) << p.size << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(12) << p.elements
+                  << std::setw(12) << format_cache_size(static_cast<long long>(p.bytes))
+                  << std::setprecision(3) << std::setw(12) << p.time_ms
+                  << std::setprecision(2) << std::setw(12) << p.ns_per_element;
+        if (next_break < analysis.breakpoints.size() && analysis.breakpoints[next_break].index == i) {
+            const SweepBreakpoint& b = analysis.breakpoints[next_break++];
+            std::cout << "  <- x" << std::setprecision(2) << b.cost_ratio;
+            if (!b.cache_level.empty()) std::cout << " past " << b.cache_level << " (" << format_cache_size(b.cache_bytes) << ")";
+        }
+        std::cout << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+    }
+    
+    std::cout << std::fixed << std::setprecision(3)
+              << "Fit: time ~ elements^" << analysis.overall.exponent << " (r^2 " << analysis.overall.r_squared << "), "
+              << std::setprecision(2) << analysis.median_ns_per_element << " ns per element (median)" << std::endl;
+    if (analysis.breakpoints.empty()) {
+        std::cout << "No breakpoints: cost per element stays within the jump threshold over the sweep" << std::endl;
+    } else {
+        for (const PowerFit& segment : analysis.segments) {
+            std::cout << "  segment " << points[segment.first].size << ".." << points[segment.last].size << ": ";
+            if (segment.last > segment.first) {
+                std::cout << std::setprecision(3) << "elements^" << segment.exponent << ", ";
+            }
+            std::cout << std::setprecision(2) << sweep_detail::median_cost(points, segment.first, segment.last)
+                      << " ns per element" << std::endl;
+        }
+    }
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6);
+}
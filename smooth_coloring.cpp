@@ -0,0 +1,243 @@
+#pragma once
+
+#include "mandelbrot_renderer.cpp"
+#include "kernel_dispatch.cpp"
+#include "cycle_timer.cpp"
+#include "worker_pool.cpp"
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#if HOT_KERNEL_CLONES
+#include <immintrin.h>
+#endif
+
+// Colouring as a pass over a finished iteration buffer, apart from the iteration
+// work. Every escaped pixel gets a continuous count, n + 1 - log2(log|z|) (the
+// normalised iteration count, with z taken three steps on), so colours no longer
+// step at integer counts. The palette is histogram-equalised: per-thread histograms
+// of the counts are merged and prefix-summed into a CDF, so each stretch of the
+// palette covers the same share of pixels however the counts bunch up at high
+// budgets. The equalised value indexes a precomputed RGB table; that step does 8
+// pixels at a time with AVX2 gathers when the CPU has them.
+
+struct EscapeImage {
+    int width = 0;
+    int height = 0;
+    int max_iterations = 0;
+    std::vector<int32_t> iterations;
+    std::vector<float> radius;      // |z| three iterations past escape, 0 inside the set
+    double elapsed_ms = 0.0;
+};
+
+struct ColoredImage {
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> rgb;      // 0xRRGGBB, row-major
+    double smooth_ms = 0.0;         // continuous counts and per-thread histograms
+    double cdf_ms = 0.0;            // merged histogram and prefix sum
+    double map_ms = 0.0;            // CDF and palette lookups
+    double elapsed_ms = 0.0;
+    int threads = 1;
+    bool simd = false;              // map ran the AVX2 path
+};
+
+// Iteration counts and escape radii of a view, rows spread over threads
+EscapeImage render_escape_image(int width, int height, int max_iterations,
+                                double x_min, double x_max, double y_min, double y_max, int threads = 0) {
+    CycleTimer& timer = CycleTimer::instance();
+    uint64_t start = timer.start();
+    EscapeImage image;
+    image.width = width;
+    image.height = height;
+    image.max_iterations = max_iterations;
+    image.iterations.resize(static_cast<size_t>(width) * height);
+    image.radius.resize(image.iterations.size());
+    MandelbrotRenderer renderer(width, height, max_iterations);
+    parallel_rows(height, threads, [&](int row) {
+        size_t offset = static_cast<size_t>(row) * width;
+        renderer.render_escape_tile(x_min, x_max, y_min, y_max, 0, row, width, 1,
+                                    image.iterations.data() + offset, image.radius.data() + offset);
+    });
+    image.elapsed_ms = timer.elapsed_ms(start, timer.stop());
+    return image;
+}
+
+// The scheme of get_colored_char: six colours in equal bands of the iteration
+// budget, one division per pixel, on one thread
+ColoredImage color_linear_bands(const EscapeImage& image) {
+    CycleTimer& timer = CycleTimer::instance();
+    uint64_t start = timer.start();
+    const uint32_t colors[] = {0x0000aa, 0x00aaaa, 0x00aa00, 0xaaaa00, 0xaa0000, 0xaa00aa};
+    ColoredImage colored;
+    colored.width = image.width;
+    colored.height = image.height;
+    colored.rgb.resize(image.iterations.size());
+    for (size_t i = 0; i < image.iterations.size(); i++) {
+        int n = image.iterations[i];
+        if (n >= image.max_iterations) {
+            colored.rgb[i] = 0;
+            continue;
+        }
+        int band = std::min(5, n * 6 / image.max_iterations);
+        colored.rgb[i] = colors[band];
+    }
+    colored.elapsed_ms = timer.elapsed_ms(start, timer.stop());
+    colored.map_ms = colored.elapsed_ms;
+    return colored;
+}
+
+class PaletteMapper {
+private:
+    int threads;
+    WorkerPool pool;
+    std::vector<uint32_t> lut;
+    // Reused from image to image
+    std::vector<float> smooth;                      // continuous count, -1 inside the set
+    std::vector<std::vector<uint32_t>> thread_bins; // one histogram per thread
+    std::vector<float> bin_start;                   // share of escaped pixels below each bin
+    std::vector<float> bin_width;                   // share in the bin
+    
+    // Ultra Fractal's gradient: dark blue, light blue, white, orange, black, dark blue
+    static uint32_t gradient(double t) {
+        const double stops[][4] = {{0.0, 0, 7, 100}, {0.16, 32, 107, 203}, {0.42, 237, 255, 255},
+                                   {0.6425, 255, 170, 0}, {0.8575, 0, 2, 0}, {1.0, 0, 7, 100}};
+        int s = 0;
+        while (s < 4 && t > stops[s + 1][0]) s++;
+        double f = (t - stops[s][0]) / (stops[s + 1][0] - stops[s][0]);
+        uint32_t rgb = 0;
+        for (int c = 1; c <= 3; c++) {
+            double value = stops[s][c] + f * (stops[s + 1][c] - stops[s][c]);
+            rgb = (rgb << 8) | static_cast<uint32_t>(std::lround(std::min(255.0, std::max(0.0, value))));
+        }
+        return rgb;
+    }
+    
+    void map_scalar(size_t first, size_t last, uint32_t* out) const {
+        const float scale = static_cast<float>(lut_size - 1);
+        for (size_t i = first; i < last; i++) {
+            float v = smooth[i];
+            if (v < 0.0f) {
+                out[i] = 0;
+                continue;
+            }
+            int bin = static_cast<int>(v);
+            float t = bin_start[bin] + (v - static_cast<float>(bin)) * bin_width[bin];
+            out[i] = lut[std::min(static_cast<int>(t * scale), lut_size - 1)];
+        }
+    }
+
+#if HOT_KERNEL_CLONES
+    // Same arithmetic as map_scalar (no FMA, so the two agree bit for bit)
+    __attribute__((target("avx2"))) void map_avx2(size_t first, size_t last, uint32_t* out) const {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 scale = _mm256_set1_ps(static_cast<float>(lut_size - 1));
+        const __m256i top = _mm256_set1_epi32(lut_size - 1);
+        const int* table = reinterpret_cast<const int*>(lut.data());
+        size_t i = first;
+        for (; i + 8 <= last; i += 8) {
+            __m256 v = _mm256_loadu_ps(smooth.data() + i);
+            __m256 inside = _mm256_cmp_ps(v, zero, _CMP_LT_OQ);
+            v = _mm256_max_ps(v, zero);
+            __m256i bin = _mm256_cvttps_epi32(v);
+            __m256 frac = _mm256_sub_ps(v, _mm256_cvtepi32_ps(bin));
+            __m256 start = _mm256_i32gather_ps(bin_start.data(), bin, 4);
+            __m256 width = _mm256_i32gather_ps(bin_width.data(), bin, 4);
+            __m256 t = _mm256_add_ps(start, _mm256_mul_ps(frac, width));
+            __m256i index = _mm256_min_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(t, scale)), top);
+            __m256i color = _mm256_i32gather_epi32(table, index, 4);
+            color = _mm256_andnot_si256(_mm256_castps_si256(inside), color);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), color);
+        }
+        map_scalar(i, last, out);
+    }
+#endif
+
+public:
+    static constexpr int lut_size = 4096;
+    
+    explicit PaletteMapper(int threads = 0) : threads(threads), lut(lut_size) {
+        for (int i = 0; i < lut_size; i++) lut[i] = gradient(static_cast<double>(i) / (lut_size - 1));
+    }
+    
+    static bool simd_available() {
+#if HOT_KERNEL_CLONES
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+    
+    ColoredImage color(const EscapeImage& image, bool use_simd = true) {
+        CycleTimer& timer = CycleTimer::instance();
+        uint64_t start = timer.start();
+        ColoredImage colored;
+        colored.width = image.width;
+        colored.height = image.height;
+        colored.threads = resolve_thread_count(threads, image.height);
+        colored.simd = use_simd && simd_available();
+        colored.rgb.resize(image.iterations.size());
+        smooth.resize(image.iterations.size());
+        
+        // n + 1 - log2(log|z|) at z three steps on; the + 3 puts it back at the escape
+        int bins = image.max_iterations + 2;
+        const float highest = static_cast<float>(bins - 1);
+        if (static_cast<int>(thread_bins.size()) < colored.threads) thread_bins.resize(colored.threads);
+        split_rows(image.height, colored.threads, [&](int t, int first_row, int end_row) {
+            std::vector<uint32_t>& histogram = thread_bins[t];
+            histogram.assign(bins, 0);
+            size_t first = static_cast<size_t>(first_row) * image.width;
+            size_t last = static_cast<size_t>(end_row) * image.width;
+            for (size_t i = first; i < last; i++) {
+                if (image.iterations[i] >= image.max_iterations) {
+                    smooth[i] = -1.0f;
+                    continue;
+                }
+                float mu = image.iterations[i] + 4.0f - std::log2(std::log(image.radius[i]));
+                mu = std::min(std::max(mu, 0.0f), highest);
+                smooth[i] = mu;
+                histogram[static_cast<int>(mu)]++;
+            }
+        }, &pool);
+        uint64_t smoothed = timer.stop();
+        colored.smooth_ms = timer.elapsed_ms(start, smoothed);
+        
+        // Merge, then turn the counts into each bin's start and width on [0, 1]
+        bin_start.assign(bins, 0.0f);
+        bin_width.assign(bins, 0.0f);
+        std::vector<uint64_t> merged(bins, 0);
+        for (int t = 0; t < colored.threads; t++) {
+            for (int b = 0; b < bins; b++) merged[b] += thread_bins[t][b];
+        }
+        uint64_t total = 0;
+        for (uint64_t count : merged) total += count;
+        if (total > 0) {
+            uint64_t below = 0;
+            for (int b = 0; b < bins; b++) {
+                bin_start[b] = static_cast<float>(static_cast<double>(below) / total);
+                bin_width[b] = static_cast<float>(static_cast<double>(merged[b]) / total);
+                below += merged[b];
+            }
+        }
+        uint64_t summed = timer.stop();
+        colored.cdf_ms = timer.elapsed_ms(smoothed, summed);
+        
+        split_rows(image.height, colored.threads, [&](int, int first_row, int end_row) {
+            size_t first = static_cast<size_t>(first_row) * image.width;
+            size_t last = static_cast<size_t>(end_row) * image.width;
+#if HOT_KERNEL_CLONES
+            if (colored.simd) {
+                map_avx2(first, last, colored.rgb.data());
+                return;
+            }
+#endif
+            map_scalar(first, last, colored.rgb.data());
+        }, &pool);
+        uint64_t end = timer.stop();
+        colored.map_ms = timer.elapsed_ms(summed, end);
+        colored.elapsed_ms = timer.elapsed_ms(start, end);
+        return colored;
+    }
+};
@@ -0,0 +1,347 @@
+#pragma once
+
+#include "mandelbrot_renderer.cpp"
+#include "cycle_timer.cpp"
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+// Multi-process Mandelbrot rendering: a coordinator splits the image into square
+// tiles and hands tile numbers to worker processes over a Unix domain socket.
+// Co-located workers write their tiles straight into a POSIX shared-memory image and
+// only report the tile number back; otherwise the iterations follow the reply on the
+// socket, which is what a worker on another host would have to do. Each worker has a
+// few tiles queued at a time, so fast workers simply come back for more. A worker
+// whose socket closes has its queued tiles handed to the others.
+
+struct TileFarmOptions {
+    int workers = 4;
+    int tile_size = 64;
+    int in_flight = 2;              // tiles queued per worker, hides the round trip
+    bool shared_memory = true;      // false: tiles come back inline on the socket
+    int kill_worker_after = -1;     // test hook: SIGKILL worker 0 after this many finished tiles
+};
+
+struct TileFarmStats {
+    bool ok = false;
+    std::string error;
+    double elapsed_ms = 0.0;        // fork to last tile, including worker start-up
+    int tiles = 0;
+    int reissued = 0;               // tiles handed out again after their worker died
+    int workers_lost = 0;
+    std::vector<int> tiles_per_worker;
+};
+
+namespace farm_detail {
+
+const uint32_t setup_magic = 0x4d524654; // "TFRM"
+
+// First message to every worker; both ends are the same binary, so native layout is fine
+struct Setup {
+    uint32_t magic = setup_magic;
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t tile_size = 0;
+    int32_t max_iterations = 0;
+    double x_min = 0.0, x_max = 0.0, y_min = 0.0, y_max = 0.0;
+    char shm_name[64] = {0};        // empty: send tiles inline
+};
+
+// Worker's first message after connect: the index it was forked for
+struct Hello {
+    uint32_t magic = setup_magic;
+    int32_t worker = -1;
+};
+
+struct Job {
+    int32_t tile;                   // -1: exit
+};
+
+struct Result {
+    int32_t tile;
+    uint32_t payload_bytes;         // 0 when the tile went to shared memory
+};
+
+bool send_full(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool recv_full(int fd, void* data, size_t size) {
+    char* p = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = recv(fd, p, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+struct TileRect {
+    int x0, y0, w, h;
+};
+
+TileRect tile_rect(int tile, int width, int height, int tile_size) {
+    int tiles_x = (width + tile_size - 1) / tile_size;
+    TileRect rect;
+    rect.x0 = (tile % tiles_x) * tile_size;
+    rect.y0 = (tile / tiles_x) * tile_size;
+    rect.w = std::min(tile_size, width - rect.x0);
+    rect.h = std::min(tile_size, height - rect.y0);
+    return rect;
+}
+
+void copy_tile(const int32_t* tile, const TileRect& rect, int32_t* image, int width) {
+    for (int row = 0; row < rect.h; row++) {
+        std::memcpy(image + static_cast<size_t>(rect.y0 + row) * width + rect.x0,
+                    tile + static_cast<size_t>(row) * rect.w, rect.w * sizeof(int32_t));
+    }
+}
+
+// Body of a worker process: connect, render tiles until told to stop
+int worker_main(const std::string& socket_path, int index) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) return 1;
+    Hello hello;
+    hello.worker = index;
+    if (!send_full(fd, &hello, sizeof(hello))) return 1;
+    
+    Setup setup;
+    if (!recv_full(fd, &setup, sizeof(setup)) || setup.magic != setup_magic) return 1;
+    size_t image_bytes = static_cast<size_t>(setup.width) * setup.height * sizeof(int32_t);
+    int32_t* image = nullptr;
+    if (setup.shm_name[0]) {
+        int shm = shm_open(setup.shm_name, O_RDWR, 0);
+        if (shm >= 0) {
+            void* mapped = mmap(nullptr, image_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, shm, 0);
+            close(shm);
+            if (mapped != MAP_FAILED) image = static_cast<int32_t*>(mapped);
+        }
+    }
+    
+    MandelbrotRenderer renderer(setup.width, setup.height, setup.max_iterations);
+    std::vector<int32_t> tile(static_cast<size_t>(setup.tile_size) * setup.tile_size);
+    Job job;
+    while (recv_full(fd, &job, sizeof(job)) && job.tile >= 0) {
+        TileRect rect = tile_rect(job.tile, setup.width, setup.height, setup.tile_size);
+        renderer.render_tile(setup.x_min, setup.x_max, setup.y_min, setup.y_max,
+                             rect.x0, rect.y0, rect.w, rect.h, tile.data());
+        Result result{job.tile, 0};
+        if (image) {
+            copy_tile(tile.data(), rect, image, setup.width);
+            if (!send_full(fd, &result, sizeof(result))) break;
+        } else {
+            result.payload_bytes = static_cast<uint32_t>(static_cast<size_t>(rect.w) * rect.h * sizeof(int32_t));
+            if (!send_full(fd, &result, sizeof(result)) || !send_full(fd, tile.data(), result.payload_bytes)) break;
+        }
+    }
+    if (image) munmap(image, image_bytes);
+    close(fd);
+    return 0;
+}
+
+} // namespace farm_detail
+
+// Renders a width x height view with local worker processes into iterations (row-major)
+TileFarmStats render_tile_farm(int width, int height, int max_iterations,
+                               double x_min, double x_max, double y_min, double y_max,
+                               const TileFarmOptions& options, std::vector<int32_t>& iterations) {
+    using namespace farm_detail;
+    CycleTimer& timer = CycleTimer::instance();
+    uint64_t start_ticks = timer.start();
+    TileFarmStats stats;
+    int tiles_x = (width + options.tile_size - 1) / options.tile_size;
+    int tiles_y = (height + options.tile_size - 1) / options.tile_size;
+    stats.tiles = tiles_x * tiles_y;
+    stats.tiles_per_worker.assign(options.workers, 0);
+    iterations.assign(static_cast<size_t>(width) * height, 0);
+    
+    std::string suffix = std::to_string(getpid());
+    std::string socket_path = "/tmp/mandelbrot_farm_" + suffix + ".sock";
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+    unlink(socket_path.c_str());
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, options.workers) != 0) {
+        if (listener >= 0) close(listener);
+        stats.error = "cannot listen on " + socket_path;
+        return stats;
+    }
+    
+    Setup setup;
+    setup.width = width;
+    setup.height = height;
+    setup.tile_size = options.tile_size;
+    setup.max_iterations = max_iterations;
+    setup.x_min = x_min;
+    setup.x_max = x_max;
+    setup.y_min = y_min;
+    setup.y_max = y_max;
+    size_t image_bytes = iterations.size() * sizeof(int32_t);
+    std::string shm_name = "/mandelbrot_farm_" + suffix;
+    int32_t* shared_image = nullptr;
+    if (options.shared_memory) {
+        int shm = shm_open(shm_name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+        if (shm >= 0 && ftruncate(shm, static_cast<off_t>(image_bytes)) == 0) {
+            void* mapped = mmap(nullptr, image_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, shm, 0);
+            if (mapped != MAP_FAILED) {
+                shared_image = static_cast<int32_t*>(mapped);
+                std::strncpy(setup.shm_name, shm_name.c_str(), sizeof(setup.shm_name) - 1);
+            }
+        }
+        if (shm >= 0) close(shm);
+    }
+    
+    struct Worker {
+        pid_t pid = -1;
+        int fd = -1;
+        std::deque<int> queued;     // in the order the worker will answer
+    };
+    std::vector<Worker> workers(options.workers);
+    for (int w = 0; w < options.workers; w++) {
+        workers[w].pid = fork();
+        if (workers[w].pid == 0) {
+            close(listener);
+            _exit(worker_main(socket_path, w)); // skip the parent's atexit handlers
+        }
+    }
+    
+    // Match connections to processes by the index each worker sends first, so the
+    // kill hook hits the right one
+    for (int connected = 0; connected < options.workers; connected++) {
+        pollfd pfd{listener, POLLIN, 0};
+        if (poll(&pfd, 1, 10000) <= 0) break;
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) break;
+        Hello hello;
+        pfd = {fd, POLLIN, 0};
+        bool greeted = poll(&pfd, 1, 10000) > 0 && recv_full(fd, &hello, sizeof(hello)) &&
+                       hello.magic == setup_magic && hello.worker >= 0 && hello.worker < options.workers;
+        Worker* owner = greeted && workers[hello.worker].fd < 0 ? &workers[hello.worker] : nullptr;
+        if (!owner || !send_full(fd, &setup, sizeof(setup))) {
+            close(fd);
+            continue;
+        }
+        owner->fd = fd;
+    }
+    
+    std::deque<int> pending;
+    for (int t = 0; t < stats.tiles; t++) pending.push_back(t);
+    auto top_up = [&](Worker& worker) {
+        while (worker.fd >= 0 && !pending.empty() && static_cast<int>(worker.queued.size()) < options.in_flight) {
+            Job job{pending.front()};
+            if (!send_full(worker.fd, &job, sizeof(job))) break; // noticed as a hang-up by poll
+            worker.queued.push_back(job.tile);
+            pending.pop_front();
+        }
+    };
+    auto lose = [&](Worker& worker) {
+        close(worker.fd);
+        worker.fd = -1;
+        stats.workers_lost++;
+        stats.reissued += static_cast<int>(worker.queued.size());
+        pending.insert(pending.begin(), worker.queued.begin(), worker.queued.end());
+        worker.queued.clear();
+    };
+    for (auto& worker : workers) top_up(worker);
+    
+    std::vector<int32_t> tile(static_cast<size_t>(options.tile_size) * options.tile_size);
+    int completed = 0;
+    bool killed = false;
+    while (completed < stats.tiles) {
+        std::vector<pollfd> fds;
+        std::vector<Worker*> owners;
+        for (auto& worker : workers) {
+            if (worker.fd < 0) continue;
+            fds.push_back({worker.fd, POLLIN, 0});
+            owners.push_back(&worker);
+        }
+        if (fds.empty()) {
+            stats.error = "every worker died";
+            break;
+        }
+        if (poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR) {
+            stats.error = "poll failed";
+            break;
+        }
+        for (size_t i = 0; i < fds.size(); i++) {
+            if (!fds[i].revents) continue;
+            Worker& worker = *owners[i];
+            Result result;
+            if (!recv_full(worker.fd, &result, sizeof(result)) || worker.queued.empty() ||
+                result.tile != worker.queued.front()) {
+                lose(worker);
+                continue;
+            }
+            TileRect rect = tile_rect(result.tile, width, height, options.tile_size);
+            if (result.payload_bytes > 0) {
+                if (result.payload_bytes != static_cast<uint32_t>(rect.w * rect.h * sizeof(int32_t)) ||
+                    !recv_full(worker.fd, tile.data(), result.payload_bytes)) {
+                    lose(worker);
+                    continue;
+                }
+                copy_tile(tile.data(), rect, shared_image ? shared_image : iterations.data(), width);
+            }
+            worker.queued.pop_front();
+            stats.tiles_per_worker[&worker - workers.data()]++;
+            completed++;
+            top_up(worker);
+            
+            if (!killed && completed == options.kill_worker_after && workers[0].pid > 0) {
+                kill(workers[0].pid, SIGKILL);
+                killed = true;
+            }
+        }
+        // Reissued tiles go to whoever has room
+        for (auto& worker : workers) top_up(worker);
+    }
+    
+    // Workers without a connection were lost, or connected after the accept loop gave
+    // up and would wait for their setup forever
+    for (auto& worker : workers) {
+        if (worker.fd >= 0) {
+            Job stop{-1};
+            send_full(worker.fd, &stop, sizeof(stop));
+            close(worker.fd);
+        } else if (worker.pid > 0) {
+            kill(worker.pid, SIGKILL);
+        }
+        if (worker.pid > 0) waitpid(worker.pid, nullptr, 0);
+    }
+    close(listener);
+    unlink(socket_path.c_str());
+    if (shared_image) {
+        std::memcpy(iterations.data(), shared_image, image_bytes);
+        munmap(shared_image, image_bytes);
+        shm_unlink(shm_name.c_str());
+    }
+    
+    stats.ok = completed == stats.tiles;
+    stats.elapsed_ms = timer.elapsed_ms(start_ticks, timer.stop());
+    return stats;
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "cycle_timer.cpp"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+// Scoped timeline spans written to per-thread ring buffers and dumped at exit as
+// Chrome trace event JSON (opens in Perfetto or chrome://tracing).
+// With tracing disabled a span is one relaxed load and a branch.
+
+namespace trace_detail {
+
+struct TraceEvent {
+    const char* name;
+    uint64_t begin_ticks;
+    uint64_t end_ticks;
+};
+
+// Written only by its owning thread; head is published with release so the
+// dumper can read the events behind it.
+struct TraceBuffer {
+    static const uint64_t capacity = 1 << 16;
+    long thread_id;
+    std::atomic<uint64_t> head{0};
+    TraceEvent events[capacity];
+};
+
+const int max_threads = 256;
+std::atomic<bool> enabled{false};
+std::atomic<TraceBuffer*> buffers[max_threads];
+std::atomic<int> buffer_count{0};
+uint64_t origin_ticks = 0;
+std::string output_path;
+
+long current_thread_id() {
+    #ifdef __linux__
+        return static_cast<long>(syscall(SYS_gettid));
+    #else
+        return static_cast<long>(getpid());
+    #endif
+}
+
+inline TraceBuffer* this_thread_buffer() {
+    thread_local TraceBuffer* buffer = nullptr;
+    if (!buffer) {
+        int index = buffer_count.fetch_add(1, std::memory_order_relaxed);
+        if (index >= max_threads) return nullptr;
+        buffer = new TraceBuffer();
+        buffer->thread_id = current_thread_id();
+        buffers[index].store(buffer, std::memory_order_release);
+    }
+    return buffer;
+}
+
+inline void record(const char* name, uint64_t begin_ticks, uint64_t end_ticks) {
+    TraceBuffer* buffer = this_thread_buffer();
+    if (!buffer) return;
+    uint64_t slot = buffer->head.load(std::memory_order_relaxed);
+    buffer->events[slot % TraceBuffer::capacity] = {name, begin_ticks, end_ticks};
+    buffer->head.store(slot + 1, std::memory_order_release);
+}
+
+std::deque<std::string>& interned_names() {
+    static std::deque<std::string> names;
+    return names;
+}
+
+std::string escape(const char* text) {
+    std::string out;
+    for (const char* p = text; *p; p++) {
+        if (*p == '"' || *p == '\\') out += '\\';
+        if (static_cast<unsigned char>(*p) < 0x20) continue;
+        out += *p;
+    }
+    return out;
+}
+
+void write_trace() {
+    if (output_path.empty()) return;
+    enabled.store(false, std::memory_order_relaxed);
+    
+    std::ofstream file(output_path);
+    if (!file.is_open()) {
+        std::cout << "Error: cannot write trace file " << output_path << std::endl;
+        return;
+    }
+    
+    CycleTimer& timer = CycleTimer::instance();
+    long pid = static_cast<long>(getpid());
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+         << ",\"args\":{\"name\":\"benchmark\"}}";
+    
+    size_t written = 0;
+    int count = std::min(buffer_count.load(std::memory_order_acquire), max_threads);
+    file.precision(15);
+    for (int b = 0; b < count; b++) {
+        TraceBuffer* buffer = buffers[b].load(std::memory_order_acquire);
+        if (!buffer) continue;
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t first = head > TraceBuffer::capacity ? head - TraceBuffer::capacity : 0;
+        for (uint64_t i = first; i < head; i++) {
+            const TraceEvent& e = buffer->events[i % TraceBuffer::capacity];
+            double ts_us = timer.ticks_to_ns(e.begin_ticks - origin_ticks) / 1000.0;
+            double dur_us = timer.ticks_to_ns(e.end_ticks - e.begin_ticks) / 1000.0;
+            file << ",\n{\"name\":\"" << escape(e.name) << "\",\"ph\":\"X\",\"pid\":" << pid
+                 << ",\"tid\":" << buffer->thread_id << ",\"ts\":" << ts_us << ",\"dur\":" << dur_us << "}";
+            written++;
+        }
+        if (head > TraceBuffer::capacity) {
+            std::cout << "Trace: thread " << buffer->thread_id << " dropped "
+                      << head - TraceBuffer::capacity << " oldest spans" << std::endl;
+        }
+    }
+    file << "\n]}\n";
+    std::cout << "Trace: " << written << " spans written to " << output_path << std::endl;
+}
+
+} // namespace trace_detail
+
+// Start recording; the trace is written to path when the process exits
+void trace_enable(const std::string& path) {
+    trace_detail::interned_names(); // constructed before the atexit hook so it outlives it
+    trace_detail::output_path = path;
+    trace_detail::this_thread_buffer(); // keep the calling thread's buffer out of later memory scopes
+    trace_detail::origin_ticks = CycleTimer::instance().start();
+    trace_detail::enabled.store(true, std::memory_order_relaxed);
+    std::atexit(trace_detail::write_trace);
+}
+
+inline bool trace_is_enabled() {
+    return trace_detail::enabled.load(std::memory_order_relaxed);
+}
+
+// Span names must outlive the process; use this for names built at run time
+const char* trace_intern(const std::string& name) {
+    static std::mutex lock;
+    std::lock_guard<std::mutex> guard(lock);
+    trace_detail::interned_names().push_back(name);
+    return trace_detail::interned_names().back().c_str();
+}
+
+class TraceSpan {
+private:
+    const char* name;
+    uint64_t begin_ticks;
+    
+public:
+    explicit TraceSpan(const char* span_name) : name(span_name), begin_ticks(0) {
+        if (trace_is_enabled()) begin_ticks = CycleTimer::instance().start();
+    }
+    
+    ~TraceSpan() {
+        if (begin_ticks != 0) {
+            trace_detail::record(name, begin_ticks, CycleTimer::instance().stop());
+        }
+    }
+    
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name)
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "cycle_timer.cpp"
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+
+// 3D wavefront planner over a voxel occupancy volume, 6- or 26-connected.
+// The storage order is a template parameter so the same search can run over a
+// plain x-fastest array or a Z-order (Morton) array, where the 26 neighbours of a
+// voxel mostly share its cache lines and pages.
+
+struct VoxelMap {
+    int size = 0;                   // cube side; the volume is size^3 voxels
+    std::vector<uint8_t> cells;     // x-fastest, 1 = occupied
+    int start[3] = {1, 1, 1};
+    int goal[3] = {1, 1, 1};
+    
+    uint8_t at(int x, int y, int z) const {
+        return cells[(static_cast<size_t>(z) * size + y) * size + x];
+    }
+};
+
+// Multi-level facility: a solid shell, floor slabs every 16 voxels with a few stairwell
+// openings, support columns and random crates
+VoxelMap generate_voxel_facility(int size, uint32_t seed) {
+    std::mt19937 rng(seed);
+    VoxelMap map;
+    map.size = size;
+    map.cells.assign(static_cast<size_t>(size) * size * size, 0);
+    auto set = [&](int x, int y, int z) { map.cells[(static_cast<size_t>(z) * size + y) * size + x] = 1; };
+    
+    for (int z = 0; z < size; z++) {
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                bool shell = x == 0 || y == 0 || z == 0 || x == size - 1 || y == size - 1 || z == size - 1;
+                bool column = x % 24 == 12 && y % 24 == 12;
+                if (shell || column) set(x, y, z);
+            }
+        }
+    }
+    
+    const int level = 16;
+    std::uniform_int_distribution<int> pos(2, size - 10);
+    for (int z = level; z < size - 1; z += level) {
+        for (int y = 1; y < size - 1; y++) {
+            for (int x = 1; x < size - 1; x++) set(x, y, z);
+        }
+        int openings = std::max(2, size / 32);
+        for (int o = 0; o < openings; o++) {
+            int ox = pos(rng), oy = pos(rng);
+            for (int y = oy; y < oy + 6; y++) {
+                for (int x = ox; x < ox + 6; x++) map.cells[(static_cast<size_t>(z) * size + y) * size + x] = 0;
+            }
+        }
+    }
+    
+    int crates = size * size / 16;
+    std::uniform_int_distribution<int> extent(1, 4);
+    for (int c = 0; c < crates; c++) {
+        int cx = pos(rng), cy = pos(rng), cz = pos(rng);
+        int ex = extent(rng), ey = extent(rng), ez = extent(rng);
+        for (int z = cz; z < cz + ez; z++) {
+            for (int y = cy; y < cy + ey; y++) {
+                for (int x = cx; x < cx + ex; x++) set(x, y, z);
+            }
+        }
+    }
+    
+    // Start and goal in opposite corners, cleared
+    map.start[0] = map.start[1] = map.start[2] = 1;
+    map.goal[0] = map.goal[1] = map.goal[2] = size - 2;
+    map.cells[(static_cast<size_t>(1) * size + 1) * size + 1] = 0;
+    map.cells[(static_cast<size_t>(size - 2) * size + size - 2) * size + size - 2] = 0;
+    return map;
+}
+
+// x-fastest, then y, then z; a neighbour is a constant offset away
+struct LinearLayout {
+    static const char* name() { return "linear"; }
+    
+    int side;
+    int64_t stride_y, stride_z;
+    
+    explicit LinearLayout(int n) : side(n), stride_y(n), stride_z(static_cast<int64_t>(n) * n) {}
+    
+    size_t size() const {
+        return static_cast<size_t>(side) * side * side;
+    }
+    
+    size_t index(int x, int y, int z) const {
+        return static_cast<size_t>(x + y * stride_y + z * stride_z);
+    }
+    
+    // Per-axis parts of the indices at -1, 0 and +1, combined by neighbour()
+    void neighbourhood(size_t i, int64_t parts[3][3]) const {
+        for (int d = 0; d < 3; d++) {
+            parts[0][d] = static_cast<int64_t>(i) + (d - 1);
+            parts[1][d] = (d - 1) * stride_y;
+            parts[2][d] = (d - 1) * stride_z;
+        }
+    }
+    
+    static size_t neighbour(const int64_t parts[3][3], int dx, int dy, int dz) {
+        return static_cast<size_t>(parts[0][dx + 1] + parts[1][dy + 1] + parts[2][dz + 1]);
+    }
+};
+
+// Bits of x, y and z interleaved (x in bit 0); the side must be a power of two.
+// Neighbours are found with masked ("dilated") arithmetic on each axis.
+struct MortonLayout {
+    static const char* name() { return "morton"; }
+    
+    int side;
+    uint64_t axis_mask[3];
+    
+    static uint64_t spread(uint64_t v) {
+        v &= 0x1fffff;
+        v = (v | v << 32) & 0x1f00000000ffffULL;
+        v = (v | v << 16) & 0x1f0000ff0000ffULL;
+        v = (v | v << 8) & 0x100f00f00f00f00fULL;
+        v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+        v = (v | v << 2) & 0x1249249249249249ULL;
+        return v;
+    }
+    
+    explicit MortonLayout(int n) : side(n) {
+        uint64_t used = spread(static_cast<uint64_t>(n - 1));
+        axis_mask[0] = used;
+        axis_mask[1] = used << 1;
+        axis_mask[2] = used << 2;
+    }
+    
+    size_t size() const {
+        return static_cast<size_t>(side) * side * side;
+    }
+    
+    size_t index(int x, int y, int z) const {
+        return static_cast<size_t>(spread(x) | spread(y) << 1 | spread(z) << 2);
+    }
+    
+    // Adds -1 or +1 to the coordinate stored in the bits of mask; carries ripple
+    // through the other axes' bits because those are forced to 1 first
+    static uint64_t add(uint64_t i, uint64_t mask, int delta) {
+        if (delta > 0) return ((i | ~mask) + 1) & mask;
+        if (delta < 0) return ((i & mask) - 1) & mask;
+        return i & mask;
+    }
+    
+    // Three shifted coordinates per axis; any of the 26 neighbours is an OR of one per axis
+    void neighbourhood(size_t i, int64_t parts[3][3]) const {
+        for (int axis = 0; axis < 3; axis++) {
+            for (int d = 0; d < 3; d++) {
+                parts[axis][d] = static_cast<int64_t>(add(i, axis_mask[axis], d - 1));
+            }
+        }
+    }
+    
+    static size_t neighbour(const int64_t parts[3][3], int dx, int dy, int dz) {
+        return static_cast<size_t>(parts[0][dx + 1] | parts[1][dy + 1] | parts[2][dz + 1]);
+    }
+};
+
+template <typename Layout>
+class VoxelPlanner {
+private:
+    Layout layout;
+    std::vector<uint8_t> occupancy;
+    std::vector<int32_t> distance;
+    std::vector<uint32_t> frontier;
+    std::vector<uint32_t> next_frontier;
+    int connectivity;
+    long reached_cells = 0;
+    int offsets[26][3];
+    
+public:
+    // The map border must be occupied: the search never checks bounds
+    VoxelPlanner(const VoxelMap& map, int neighbours)
+        : layout(map.size), occupancy(layout.size(), 1), distance(layout.size(), -1),
+          connectivity(neighbours == 26 ? 26 : 6) {
+        for (int z = 0; z < map.size; z++) {
+            for (int y = 0; y < map.size; y++) {
+                for (int x = 0; x < map.size; x++) {
+                    occupancy[layout.index(x, y, z)] = map.at(x, y, z);
+                }
+            }
+        }
+        // Face neighbours first, then edges and corners
+        int count = 0;
+        const int faces[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+        for (const auto& f : faces) {
+            offsets[count][0] = f[0];
+            offsets[count][1] = f[1];
+            offsets[count][2] = f[2];
+            count++;
+        }
+        for (int dz = -1; dz <= 1; dz++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    if (std::abs(dx) + std::abs(dy) + std::abs(dz) < 2) continue;
+                    offsets[count][0] = dx;
+                    offsets[count][1] = dy;
+                    offsets[count][2] = dz;
+                    count++;
+                }
+            }
+        }
+    }
+    
+    // Level-synchronous BFS from the goal over the whole free volume (getDistance then
+    // answers any start); diagonal moves may squeeze past occupied voxels
+    double planPath(const int goal[3]) {
+        CycleTimer& timer = CycleTimer::instance();
+        uint64_t start_ticks = timer.start();
+        
+        std::fill(distance.begin(), distance.end(), -1);
+        frontier.clear();
+        size_t goal_index = layout.index(goal[0], goal[1], goal[2]);
+        distance[goal_index] = 0;
+        frontier.push_back(static_cast<uint32_t>(goal_index));
+        reached_cells = 1;
+        
+        int level = 0;
+        while (!frontier.empty()) {
+            level++;
+            next_frontier.clear();
+            int64_t parts[3][3];
+            for (uint32_t cell : frontier) {
+                layout.neighbourhood(cell, parts);
+                for (int n = 0; n < connectivity; n++) {
+                    size_t next = Layout::neighbour(parts, offsets[n][0], offsets[n][1], offsets[n][2]);
+                    if (occupancy[next] == 0 && distance[next] < 0) {
+                        distance[next] = level;
+                        next_frontier.push_back(static_cast<uint32_t>(next));
+                    }
+                }
+            }
+            reached_cells += static_cast<long>(next_frontier.size());
+            frontier.swap(next_frontier);
+        }
+        
+        uint64_t end_ticks = timer.stop();
+        return timer.elapsed_ms(start_ticks, end_ticks);
+    }
+    
+    int getDistance(int x, int y, int z) const {
+        return distance[layout.index(x, y, z)];
+    }
+    
+    long getReachedCells() const {
+        return reached_cells;
+    }
+    
+    // Bytes of the occupancy and distance volumes (the frontiers come on top)
+    size_t footprintBytes() const {
+        return occupancy.size() * sizeof(uint8_t) + distance.size() * sizeof(int32_t);
+    }
+};
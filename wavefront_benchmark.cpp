@@ -1,291 +1,653 @@
+#include "host_fingerprint.cpp"
+#include "cycle_timer.cpp"
+#include "wavefront_planner.cpp"
+#include "map_generators.cpp"
+#include "distance_transform.cpp"
+#include "voxel_planner.cpp"
+#include "hierarchical_planner.cpp"
+#include "distance_field_store.cpp"
+#include "multi_source_bfs.cpp"
+#include "scaling_sweep.cpp"
 #include <iostream>
+#include <iomanip>
+#include <string>
 #include <vector>
-#include <queue>
-#include <chrono>
-#include <thread>
-#include <cstdlib>
-#include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
 #include <sstream>
 
-class WaveFrontPlanner {
-private:
-    std::vector<std::vector<int>> grid;
-    std::vector<std::vector<int>> distance;
-    int width, height;
-    
-public:
-    WaveFrontPlanner(int w, int h) : width(w), height(h) {
-        grid.resize(height, std::vector<int>(width, 0));
-        distance.resize(height, std::vector<int>(width, -1));
-        
-        // Generate maze-like obstacles
-        for (int i = 0; i < height; i++) {
-            for (int j = 0; j < width; j++) {
-                if (i == 0 || i == height-1 || j == 0 || j == width-1) {
-                    grid[i][j] = 1; // walls at borders
-                } else if ((i % 4 == 2) && (j % 4 == 2)) {
-                    grid[i][j] = 1; // scattered obstacles
+struct BenchmarkOptions {
+    std::string only;       // run just this section: demo, sizes, maps, inflation, voxels, hpa, fields, batch or scaling
+    uint32_t seed = 42;
+    int map_size = 400;
+    int repeats = 3;
+    std::vector<int> voxel_sizes = {128, 256, 512};
+    int sweep_max = 2048;   // largest grid side of the scaling sweep
+    
+    bool wants(const std::string& section) const {
+        return only.empty() || only == section;
+    }
+    
+    static bool known_section(const std::string& name) {
+        const char* sections[] = {"demo", "sizes", "maps", "inflation", "voxels", "hpa", "fields", "batch", "scaling"};
+        return std::find(std::begin(sections), std::end(sections), name) != std::end(sections);
+    }
+};
+
+bool parse_options(int argc, char* argv[], BenchmarkOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string value;
+        size_t eq = arg.find('=');
+        if (eq != std::string::npos) {
+            value = arg.substr(eq + 1);
+            arg = arg.substr(0, eq);
+        }
+        try {
+            if (arg == "--only" && !value.empty()) {
+                if (!BenchmarkOptions::known_section(value)) throw std::invalid_argument(value);
+                options.only = value;
+            } else if (arg == "--seed") {
+                options.seed = static_cast<uint32_t>(std::stoul(value));
+            } else if (arg == "--map-size") {
+                options.map_size = std::stoi(value);
+                if (options.map_size < 16) throw std::invalid_argument(value);
+            } else if (arg == "--voxel-sizes") {
+                options.voxel_sizes.clear();
+                std::stringstream list(value);
+                std::string item;
+                while (std::getline(list, item, ',')) {
+                    int size = std::stoi(item);
+                    if (size < 8 || (size & (size - 1)) != 0) throw std::invalid_argument(item);
+                    options.voxel_sizes.push_back(size);
                 }
+            } else if (arg == "--sweep-max") {
+                options.sweep_max = std::stoi(value);
+                if (options.sweep_max < 64) throw std::invalid_argument(value);
+            } else if (arg == "--repeat") {
+                options.repeats = std::max(1, std::stoi(value));
+            } else {
+                return false;
             }
+        } catch (const std::exception&) {
+            std::cout << "Invalid value for " << arg << ": '" << value << "'" << std::endl;
+            return false;
         }
     }
+    return true;
+}
+
+void print_usage() {
+    std::cout << "Usage: wavefront_benchmark [options]\n"
+              << "  --only=SECTION   run one section: demo, sizes, maps, inflation,\n                   voxels, hpa, fields, batch, scaling\n"
+              << "  --seed=N         seed of the generated maps (default 42)\n"
+              << "  --map-size=N     side length of the generated maps (default 400)\n"
+              << "  --repeat=N       runs per map and mode, the fastest is reported (default 3)\n"
+              << "  --voxel-sizes=L  comma-separated power-of-two cube sides (default 128,256,512)\n"
+              << "  --sweep-max=N    largest grid side of the scaling sweep (default 2048)\n";
+}
+
+// Planner modes exercised on every map class
+struct PlannerMode {
+    std::string name;
+    int connectivity;
+};
+
+// Runs every planner mode over every map class and reports labelled cells per second
+void run_map_classes(const BenchmarkOptions& options) {
+    std::vector<PlannerMode> modes = {{"4-connected", 4}, {"8-connected", 8}};
     
-    void displayGrid() {
-        std::cout << "\033[2J\033[H"; // Clear screen and move cursor to top
-        for (int i = 0; i < height; i++) {
-            for (int j = 0; j < width; j++) {
-                if (grid[i][j] == 1) {
-                    std::cout << "█";
-                } else if (distance[i][j] == -1) {
-                    std::cout << " ";
-                } else {
-                    char c = '0' + (distance[i][j] % 10);
-                    if (distance[i][j] >= 10) c = 'A' + ((distance[i][j] - 10) % 6);
-                    std::cout << c;
-                }
+    CycleTimer& timer = CycleTimer::instance();
+    uint64_t gen_start = timer.start();
+    std::vector<MapInstance> maps = generate_map_suite(options.map_size, options.seed);
+    double gen_ms = timer.elapsed_ms(gen_start, timer.stop());
+    std::cout << maps.size() << " map classes of " << options.map_size << "x" << options.map_size
+              << " generated in " << gen_ms << " ms (seed " << options.seed << ")" << std::endl;
+    
+    std::cout << std::left << std::setw(13) << "Map" << std::setw(13) << "Mode"
+              << std::right << std::setw(8) << "Free%" << std::setw(10) << "Reached"
+              << std::setw(9) << "Path" << std::setw(11) << "Time ms" << std::setw(12) << "Mcells/s" << std::endl;
+    
+    for (const auto& map : maps) {
+        long free_cells = 0;
+        for (const auto& row : map.grid) {
+            for (int cell : row) free_cells += cell == 0;
+        }
+        double free_percent = 100.0 * free_cells / (static_cast<double>(map.grid.size()) * map.grid[0].size());
+        
+        for (const auto& mode : modes) {
+            WaveFrontPlanner planner(map.grid);
+            planner.setConnectivity(mode.connectivity);
+            double best_ms = 0.0;
+            for (int r = 0; r < options.repeats; r++) {
+                double ms = planner.planPath(map.start_x, map.start_y, map.goal_x, map.goal_y, false);
+                if (r == 0 || ms < best_ms) best_ms = ms;
             }
-            std::cout << std::endl;
+            double mcells = best_ms > 0.0 ? planner.getReachedCells() / (best_ms * 1000.0) : 0.0;
+            int path = planner.getDistance(map.start_x, map.start_y);
+            
+            std::cout << std::left << std::setw(13) << map.name << std::setw(13) << mode.name << std::right
+                      << std::fixed << std::setprecision(1) << std::setw(8) << free_percent
+                      << std::setw(10) << planner.getReachedCells()
+                      << std::setw(9) << (path < 0 ? std::string("-") : std::to_string(path))
+                      << std::setprecision(3) << std::setw(11) << best_ms
+                      << std::setprecision(1) << std::setw(12) << mcells << std::endl;
+            std::cout.unsetf(std::ios::fixed);
+            std::cout << std::setprecision(6);
         }
-        std::cout.flush();
     }
+}
+
+// EDT-based inflation against per-obstacle disc stamping on large maps
+void run_inflation(const BenchmarkOptions& options) {
+    CycleTimer& timer = CycleTimer::instance();
+    int threads = default_thread_count();
+    std::vector<int> sizes = {1000, 2000, 4000};
+    std::vector<double> radii = {2.0, 6.0};
     
-    double planPath(int startX, int startY, int goalX, int goalY, bool visualize = true) {
-        auto start_time = std::chrono::high_resolution_clock::now();
+    std::cout << "EDT on " << threads << " thread(s)" << std::endl;
+    std::cout << std::left << std::setw(11) << "Map" << std::right << std::setw(8) << "Radius"
+              << std::setw(12) << "EDT 1T ms" << std::setw(12) << "EDT NT ms" << std::setw(11) << "Mcells/s"
+              << std::setw(12) << "Stamp ms" << std::setw(10) << "Speedup" << std::setw(8) << "Match" << std::endl;
+    
+    for (int size : sizes) {
+        MapInstance map = generate_caves(size, size, options.seed);
+        double cells = static_cast<double>(size) * size;
         
-        // Reset distance grid
-        for (auto& row : distance) {
-            std::fill(row.begin(), row.end(), -1);
-        }
+        // The transform does not depend on the radius, so it is timed once per map
+        uint64_t t0 = timer.start();
+        ClearanceMap serial = euclidean_distance_transform(map.grid, 1);
+        double edt_serial_ms = timer.elapsed_ms(t0, timer.stop());
+        t0 = timer.start();
+        ClearanceMap clearance = euclidean_distance_transform(map.grid, threads);
+        double edt_ms = timer.elapsed_ms(t0, timer.stop());
         
-        std::queue<std::pair<int, int>> queue;
-        queue.push({goalY, goalX});
-        distance[goalY][goalX] = 0;
+        for (double radius : radii) {
+            t0 = timer.start();
+            OccupancyGrid inflated = inflate_obstacles(clearance, radius);
+            double inflate_ms = edt_ms + timer.elapsed_ms(t0, timer.stop());
+            
+            t0 = timer.start();
+            OccupancyGrid stamped = inflate_by_disk_stamping(map.grid, radius);
+            double stamp_ms = timer.elapsed_ms(t0, timer.stop());
+            
+            std::cout << std::left << std::setw(11) << ("caves " + std::to_string(size)) << std::right
+                      << std::fixed << std::setprecision(1) << std::setw(8) << radius
+                      << std::setprecision(2) << std::setw(12) << edt_serial_ms << std::setw(12) << edt_ms
+                      << std::setprecision(1) << std::setw(11) << cells / (edt_ms * 1000.0)
+                      << std::setprecision(2) << std::setw(12) << stamp_ms
+                      << std::setprecision(1) << std::setw(9) << stamp_ms / inflate_ms << "x"
+                      << std::setw(8) << (inflated == stamped && serial.squared == clearance.squared ? "yes" : "NO") << std::endl;
+            std::cout.unsetf(std::ios::fixed);
+            std::cout << std::setprecision(6);
+        }
+    }
+    
+    // The inflated map is what the planner searches for a robot of that radius.
+    // Start and goal are the roomiest cells of opposite corner quadrants.
+    MapInstance map = generate_caves(options.map_size, options.map_size, options.seed);
+    ClearanceMap clearance = euclidean_distance_transform(map.grid, threads);
+    auto roomiest = [&](int x0, int y0) {
+        int half = options.map_size / 2;
+        std::pair<int, int> best = {x0, y0};
+        for (int y = y0; y < y0 + half; y++) {
+            for (int x = x0; x < x0 + half; x++) {
+                if (clearance.clearance(x, y) > clearance.clearance(best.first, best.second)) best = {x, y};
+            }
+        }
+        return best;
+    };
+    auto start = roomiest(0, 0);
+    auto goal = roomiest(options.map_size / 2, options.map_size / 2);
+    
+    std::cout << "\nCaves " << options.map_size << "x" << options.map_size << " path length by robot radius:";
+    for (double radius : {0.0, 1.0, 1.5, 2.0, 3.0}) {
+        WaveFrontPlanner planner(radius > 0.0 ? inflate_obstacles(clearance, radius) : map.grid);
+        planner.planPath(start.first, start.second, goal.first, goal.second, false);
+        int length = planner.getDistance(start.first, start.second);
+        std::cout << "  r=" << radius << ": " << (length < 0 ? std::string("blocked") : std::to_string(length));
+    }
+    std::cout << std::endl;
+}
+
+// One layout/connectivity combination of the voxel sweep
+template <typename Layout>
+void run_voxel_case(const VoxelMap& map, int connectivity, int& path_length) {
+    VoxelPlanner<Layout> planner(map, connectivity);
+    #ifdef __linux__
+    PerfCounter llc_misses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    PerfCounter l1d_misses(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    #else
+    PerfCounter llc_misses(0, 0);
+    PerfCounter l1d_misses(0, 0);
+    #endif
+    
+    llc_misses.start();
+    l1d_misses.start();
+    double ms = planner.planPath(map.goal);
+    uint64_t llc = llc_misses.stop();
+    uint64_t l1d = l1d_misses.stop();
+    path_length = planner.getDistance(map.start[0], map.start[1], map.start[2]);
+    
+    auto count = [](const PerfCounter& counter, uint64_t value) {
+        return counter.valid() ? std::to_string(value / 1000) + "k" : std::string("n/a");
+    };
+    std::cout << std::left << std::setw(8) << (std::to_string(map.size) + "^3") << std::setw(6) << connectivity
+              << std::setw(8) << Layout::name() << std::right << std::fixed << std::setprecision(1)
+              << std::setw(11) << ms << std::setw(10) << planner.getReachedCells() / (ms * 1000.0)
+              << std::setw(13) << count(llc_misses, llc) << std::setw(13) << count(l1d_misses, l1d)
+              << std::setw(10) << planner.footprintBytes() / (1024.0 * 1024.0)
+              << std::setw(8) << path_length << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6);
+}
+
+// Morton against linear storage of the same voxel volume
+void run_voxels(const BenchmarkOptions& options) {
+    std::cout << std::left << std::setw(8) << "Volume" << std::setw(6) << "Conn" << std::setw(8) << "Layout"
+              << std::right << std::setw(11) << "Time ms" << std::setw(10) << "Mvox/s" << std::setw(13) << "LLC misses"
+              << std::setw(13) << "L1D misses" << std::setw(10) << "MiB" << std::setw(8) << "Path" << std::endl;
+    
+    double memory_mb = get_host_fingerprint().memory_total_kb / 1024.0;
+    for (int size : options.voxel_sizes) {
+        // Occupancy, distance and two worst-case frontiers
+        double needed_mb = static_cast<double>(size) * size * size * (1 + 4 + 4) / (1024.0 * 1024.0);
+        if (memory_mb > 0 && needed_mb > memory_mb / 2) {
+            std::cout << size << "^3 skipped: needs about " << static_cast<int>(needed_mb) << " MiB" << std::endl;
+            continue;
+        }
+        VoxelMap map = generate_voxel_facility(size, options.seed);
+        for (int connectivity : {6, 26}) {
+            int linear_path = 0, morton_path = 0;
+            run_voxel_case<LinearLayout>(map, connectivity, linear_path);
+            run_voxel_case<MortonLayout>(map, connectivity, morton_path);
+            if (linear_path != morton_path) {
+                std::cout << "Error: layouts disagree on the path length" << std::endl;
+            }
+        }
+    }
+}
+
+// Free cell pairs that the exact planner can connect, drawn with a fixed seed
+std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> random_queries(const OccupancyGrid& grid, int count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    int height = static_cast<int>(grid.size());
+    int width = static_cast<int>(grid[0].size());
+    std::uniform_int_distribution<int> rx(1, width - 2), ry(1, height - 2);
+    auto free_cell = [&] {
+        while (true) {
+            int x = rx(rng), y = ry(rng);
+            if (grid[y][x] == 0) return std::make_pair(x, y);
+        }
+    };
+    std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> queries;
+    for (int i = 0; i < count; i++) {
+        queries.push_back({free_cell(), free_cell()});
+    }
+    return queries;
+}
+
+// HPA* preprocessing, repair and query cost against the exact full-grid wavefront
+void run_hierarchical(const BenchmarkOptions& options) {
+    CycleTimer& timer = CycleTimer::instance();
+    const int size = 1000;
+    const int query_count = 20;
+    std::vector<MapInstance> maps = {generate_caves(size, size, options.seed),
+                                     generate_warehouse(size, size, options.seed),
+                                     generate_random(size, size, options.seed, 0.20)};
+    
+    std::cout << std::left << std::setw(11) << "Map" << std::right << std::setw(8) << "Cluster"
+              << std::setw(11) << "Build ms" << std::setw(8) << "Nodes" << std::setw(9) << "Edges"
+              << std::setw(9) << "KiB" << std::setw(11) << "Repair ms" << std::setw(11) << "Query us"
+              << std::setw(12) << "Refine us" << std::setw(11) << "Exact ms" << std::setw(10) << "Subopt%"
+              << std::setw(9) << "Max%" << std::endl;
+    
+    for (const auto& map : maps) {
+        auto queries = random_queries(map.grid, query_count * 3, options.seed);
         
-        int dx[] = {-1, 1, 0, 0};
-        int dy[] = {0, 0, -1, 1};
+        // Exact distances, one full wavefront from each goal; unreachable pairs are dropped
+        WaveFrontPlanner exact(map.grid);
+        std::vector<int> exact_length;
+        std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> kept;
+        double exact_ms = 0.0;
+        for (const auto& q : queries) {
+            double ms = exact.planPath(q.first.first, q.first.second, q.second.first, q.second.second, false);
+            int d = exact.getDistance(q.first.first, q.first.second);
+            if (d < 0) continue;
+            exact_ms += ms;
+            exact_length.push_back(d);
+            kept.push_back(q);
+            if (static_cast<int>(kept.size()) == query_count) break;
+        }
         
-        while (!queue.empty()) {
-            auto [y, x] = queue.front();
-            queue.pop();
+        for (int cluster : {16, 32, 64}) {
+            HierarchicalPlanner hpa(map.grid, cluster);
+            uint64_t t0 = timer.start();
+            hpa.build();
+            double build_ms = timer.elapsed_ms(t0, timer.stop());
             
-            if (visualize) {
-                displayGrid();
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            double query_ms = 0.0, refine_ms = 0.0, subopt_sum = 0.0, subopt_max = 0.0;
+            int found = 0;
+            for (size_t i = 0; i < kept.size(); i++) {
+                const auto& q = kept[i];
+                t0 = timer.start();
+                HierarchicalPath path = hpa.findPath(q.first.first, q.first.second, q.second.first, q.second.second);
+                uint64_t t1 = timer.stop();
+                hpa.refine(q.first.first, q.first.second, q.second.first, q.second.second, path);
+                uint64_t t2 = timer.stop();
+                query_ms += timer.elapsed_ms(t0, t1);
+                refine_ms += timer.elapsed_ms(t1, t2);
+                if (path.length < 0 || static_cast<int>(path.cells.size()) != path.length + 1) {
+                    std::cout << "Error: no or inconsistent hierarchical path for query " << i << std::endl;
+                    continue;
+                }
+                double subopt = 100.0 * (path.length - exact_length[i]) / std::max(1, exact_length[i]);
+                subopt_sum += subopt;
+                subopt_max = std::max(subopt_max, subopt);
+                found++;
             }
             
-            for (int i = 0; i < 4; i++) {
-                int ny = y + dy[i];
-                int nx = x + dx[i];
-                
-                if (nx >= 0 && nx < width && ny >= 0 && ny < height &&
-                    grid[ny][nx] == 0 && distance[ny][nx] == -1) {
-                    distance[ny][nx] = distance[y][x] + 1;
-                    queue.push({ny, nx});
-                }
+            // Repair cost: toggle random cells, each followed by the local rebuild
+            std::mt19937 rng(options.seed);
+            std::uniform_int_distribution<int> coord(1, size - 2);
+            const int changes = 50;
+            t0 = timer.start();
+            for (int c = 0; c < changes; c++) {
+                int x = coord(rng), y = coord(rng);
+                hpa.setCell(x, y, 1 - hpa.getGrid()[y][x]);
             }
+            double repair_ms = timer.elapsed_ms(t0, timer.stop()) / changes;
+            
+            int n = std::max(1, found);
+            std::cout << std::left << std::setw(11) << map.name << std::right << std::setw(8) << cluster
+                      << std::fixed << std::setprecision(1) << std::setw(11) << build_ms
+                      << std::setw(8) << hpa.getNodeCount() << std::setw(9) << hpa.getEdgeCount()
+                      << std::setw(9) << hpa.getMemoryBytes() / 1024.0
+                      << std::setprecision(3) << std::setw(11) << repair_ms
+                      << std::setprecision(1) << std::setw(11) << query_ms * 1000.0 / n
+                      << std::setw(12) << refine_ms * 1000.0 / n
+                      << std::setprecision(3) << std::setw(11) << exact_ms / std::max<size_t>(1, kept.size())
+                      << std::setprecision(2) << std::setw(10) << subopt_sum / n
+                      << std::setw(9) << subopt_max << std::endl;
+            std::cout.unsetf(std::ios::fixed);
+            std::cout << std::setprecision(6);
         }
+    }
+}
+
+// Drops the file from the page cache so the next open reads it from the device
+void evict_from_page_cache(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+// Warm start from a stored distance field versus recomputing it
+void run_distance_fields(const BenchmarkOptions& options) {
+    CycleTimer& timer = CycleTimer::instance();
+    const int size = 2000;
+    const std::string dir = "distance_fields";
+    mkdir(dir.c_str(), 0755);
+    std::vector<MapInstance> maps = {generate_open(size, size),
+                                     generate_caves(size, size, options.seed),
+                                     generate_maze(size, size, options.seed)};
+    
+    std::cout << std::left << std::setw(11) << "Map" << std::setw(11) << "Encoding" << std::right
+              << std::setw(10) << "File KiB" << std::setw(10) << "Save ms" << std::setw(10) << "MB/s"
+              << std::setw(10) << "Open ms" << std::setw(10) << "MB/s" << std::setw(11) << "Query ms"
+              << std::setw(10) << "Cold ms" << std::setw(12) << "Recompute" << std::setw(7) << "Match" << std::endl;
+    
+    for (const auto& map : maps) {
+        // Recompute path: what a restart costs today
+        uint64_t t0 = timer.start();
+        WaveFrontPlanner planner(map.grid);
+        planner.planPath(map.start_x, map.start_y, map.goal_x, map.goal_y, false);
+        std::vector<std::pair<int, int>> expected = planner.getPath(map.start_x, map.start_y);
+        double recompute_ms = timer.elapsed_ms(t0, timer.stop());
+        uint64_t map_hash = occupancy_hash(map.grid);
         
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
-        
-        if (visualize) {
-            displayGrid();
-            std::cout << "\nPath planning completed!" << std::endl;
-            std::cout << "Path length from start to goal: " << distance[startY][startX] << std::endl;
+        for (DistanceEncoding encoding : {DistanceEncoding::Raw16, DistanceEncoding::Raw32, DistanceEncoding::DeltaRle}) {
+            std::string path = distance_field_path(dir, map_hash, map.goal_x, map.goal_y) + "." + encoding_name(encoding);
+            std::string error;
+            t0 = timer.start();
+            bool saved = save_distance_field(path, planner, map.goal_x, map.goal_y, encoding, error);
+            double save_ms = timer.elapsed_ms(t0, timer.stop());
+            std::cout << std::left << std::setw(11) << map.name << std::setw(11) << encoding_name(encoding) << std::right;
+            if (!saved) {
+                std::cout << "  not stored: " << error << std::endl;
+                continue;
+            }
+            evict_from_page_cache(path);
             
-            // Show optimal path from goal to start
-            if (distance[startY][startX] != -1) {
-                std::cout << "\nTracing optimal path (goal to start)..." << std::endl;
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                
-                // Build complete path first
-                std::vector<std::pair<int, int>> path;
-                int curr_x = startX, curr_y = startY;
-                path.push_back({curr_x, curr_y});
-                
-                while (curr_x != goalX || curr_y != goalY) {
-                    int dx[] = {-1, 1, 0, 0};
-                    int dy[] = {0, 0, -1, 1};
-                    
-                    for (int i = 0; i < 4; i++) {
-                        int nx = curr_x + dx[i];
-                        int ny = curr_y + dy[i];
-                        
-                        if (nx >= 0 && nx < width && ny >= 0 && ny < height &&
-                            distance[ny][nx] != -1 && distance[ny][nx] < distance[curr_y][curr_x]) {
-                            curr_x = nx;
-                            curr_y = ny;
-                            path.push_back({curr_x, curr_y});
-                            break;
-                        }
+            // Cold start: hash the map, open and verify the file, answer the first query
+            t0 = timer.start();
+            MappedDistanceField field;
+            bool opened = field.open(path, map.grid, error);
+            uint64_t t1 = timer.stop();
+            std::vector<std::pair<int, int>> route;
+            if (opened) route = field.getPath(map.start_x, map.start_y);
+            uint64_t t2 = timer.stop();
+            if (!opened) {
+                std::cout << "  load failed: " << error << std::endl;
+                continue;
+            }
+            
+            bool match = route == expected;
+            for (int y = 0; y < size && match; y++) {
+                for (int x = 0; x < size; x++) {
+                    if (field.getDistance(x, y) != planner.getDistance(x, y)) {
+                        match = false;
+                        break;
                     }
                 }
-                
-                // Animate path highlighting
-                for (size_t step = 0; step < path.size(); step++) {
-                    std::cout << "\033[2J\033[H";
-                    for (int i = 0; i < height; i++) {
-                        for (int j = 0; j < width; j++) {
-                            bool on_path = false;
-                            bool current_step = false;
-                            
-                            // Check if this position is on the path and already highlighted
-                            for (size_t p = 0; p <= step; p++) {
-                                if (path[p].first == j && path[p].second == i) {
-                                    on_path = true;
-                                    if (p == step) current_step = true;
+            }
+            
+            double file_mb = field.getFileBytes() / 1e6;
+            double open_ms = timer.elapsed_ms(t0, t1);
+            std::cout << std::fixed << std::setprecision(1) << std::setw(10) << field.getFileBytes() / 1024.0
+                      << std::setw(10) << save_ms << std::setw(10) << file_mb / (save_ms / 1000.0)
+                      << std::setw(10) << open_ms << std::setw(10) << file_mb / (open_ms / 1000.0)
+                      << std::setprecision(3) << std::setw(11) << timer.elapsed_ms(t1, t2)
+                      << std::setprecision(1) << std::setw(10) << timer.elapsed_ms(t0, t2)
+                      << std::setw(12) << recompute_ms << std::setw(7) << (match ? "yes" : "NO") << std::endl;
+            std::cout.unsetf(std::ios::fixed);
+            std::cout << std::setprecision(6);
+            field.close();
+            std::remove(path.c_str());
+        }
+    }
+    
+    // A stored field must not be trusted for another map or after corruption
+    MapInstance map = generate_caves(256, 256, options.seed);
+    WaveFrontPlanner planner(map.grid);
+    planner.planPath(map.start_x, map.start_y, map.goal_x, map.goal_y, false);
+    std::string path = distance_field_path(dir, occupancy_hash(map.grid), map.goal_x, map.goal_y);
+    std::string error;
+    MappedDistanceField field;
+    if (save_distance_field(path, planner, map.goal_x, map.goal_y, DistanceEncoding::Raw16, error)) {
+        bool other_map = !field.open(path, generate_caves(256, 256, options.seed + 1).grid, error);
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(offsetof(DistanceFieldHeader, connectivity));
+        file.put('\x7f');
+        file.flush();
+        bool bad_header = !field.open(path, map.grid, error, false) && !field.open(path, map.grid, error);
+        file.seekp(offsetof(DistanceFieldHeader, connectivity));
+        file.put('\x04');
+        file.seekp(sizeof(DistanceFieldHeader) + 1000);
+        file.put('\x7f');
+        file.close();
+        bool corrupted = !field.open(path, map.grid, error);
+        std::cout << "Rejected for another map: " << (other_map ? "yes" : "NO")
+                  << ", with a damaged header: " << (bad_header ? "yes" : "NO")
+                  << ", after payload corruption: " << (corrupted ? "yes" : "NO") << std::endl;
+        std::remove(path.c_str());
+    }
+    rmdir(dir.c_str());
+}
+
+// Goals drawn from a square window around a random free cell, like docks in one yard
+std::vector<std::pair<int, int>> clustered_goals(const OccupancyGrid& grid, int count, int window, uint32_t seed) {
+    std::mt19937 rng(seed);
+    int height = static_cast<int>(grid.size());
+    int width = static_cast<int>(grid[0].size());
+    auto centre = random_queries(grid, 1, seed)[0].first;
+    int x0 = std::max(1, std::min(centre.first - window / 2, width - 1 - window));
+    int y0 = std::max(1, std::min(centre.second - window / 2, height - 1 - window));
+    std::uniform_int_distribution<int> offset(0, window - 1);
+    std::vector<std::pair<int, int>> goals;
+    while (static_cast<int>(goals.size()) < count) {
+        int x = x0 + offset(rng), y = y0 + offset(rng);
+        if (grid[y][x] == 0) goals.push_back({x, y});
+    }
+    return goals;
+}
+
+// K goal fields from one batched sweep versus K planPath calls. Searches only share
+// work where their frontiers meet a cell at the same level, so goals spread over the
+// map and goals clustered in one area are reported separately.
+void run_multi_goal(const BenchmarkOptions& options) {
+    std::vector<MapInstance> maps = {generate_caves(options.map_size, options.map_size, options.seed),
+                                     generate_warehouse(options.map_size, options.map_size, options.seed)};
+    std::vector<PlannerMode> modes = {{"4-connected", 4}, {"8-connected", 8}};
+    
+    std::cout << std::left << std::setw(11) << "Map" << std::setw(13) << "Mode" << std::setw(11) << "Goals" << std::right
+              << std::setw(4) << "K" << std::setw(15) << "Sequential ms" << std::setw(11) << "Batch ms"
+              << std::setw(14) << "Seq fields/s" << std::setw(16) << "Batch fields/s" << std::setw(9) << "Speedup"
+              << std::setw(7) << "Match" << std::endl;
+    
+    for (const auto& map : maps) {
+        std::vector<std::pair<int, int>> spread;
+        for (const auto& pair : random_queries(map.grid, 64, options.seed)) spread.push_back(pair.second);
+        std::vector<std::pair<std::string, std::vector<std::pair<int, int>>>> goal_sets = {
+            {"spread", spread}, {"clustered", clustered_goals(map.grid, 64, 24, options.seed)}};
+        for (const auto& mode : modes) {
+            for (const auto& goal_set : goal_sets) {
+                for (int k : {8, 64}) {
+                    std::vector<std::pair<int, int>> goals(goal_set.second.begin(), goal_set.second.begin() + k);
+                    
+                    MultiSourcePlanner batch(map.grid, mode.connectivity);
+                    double batch_ms = batch.planFields(goals);
+                    
+                    // Sequential fields, checked cell by cell against the batch (outside the timing)
+                    WaveFrontPlanner planner(map.grid);
+                    planner.setConnectivity(mode.connectivity);
+                    double sequential_ms = 0.0;
+                    bool match = true;
+                    for (int g = 0; g < k; g++) {
+                        sequential_ms += planner.planPath(goals[g].first, goals[g].second, goals[g].first, goals[g].second, false);
+                        for (int y = 0; y < options.map_size && match; y++) {
+                            for (int x = 0; x < options.map_size; x++) {
+                                if (batch.getDistance(g, x, y) != planner.getDistance(x, y)) {
+                                    match = false;
                                     break;
                                 }
                             }
-                            
-                            if (grid[i][j] == 1) {
-                                std::cout << "█";
-                            } else if (on_path) {
-                                if (current_step) {
-                                    std::cout << "\033[1;33m*\033[0m"; // Bright yellow for current
-                                } else {
-                                    std::cout << "\033[1;32m#\033[0m"; // Bright green for path
-                                }
-                            } else if (distance[i][j] == -1) {
-                                std::cout << " ";
-                            } else {
-                                // Dim the background numbers
-                                char c = '0' + (distance[i][j] % 10);
-                                if (distance[i][j] >= 10) c = 'A' + ((distance[i][j] - 10) % 6);
-                                std::cout << "\033[2m" << c << "\033[0m"; // Dim
-                            }
                         }
-                        std::cout << std::endl;
                     }
-                    std::cout << "Path step " << (step + 1) << "/" << path.size() 
-                              << " at (" << path[step].first << "," << path[step].second << ")" << std::endl;
-                    std::cout.flush();
                     
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    std::cout << std::left << std::setw(11) << map.name << std::setw(13) << mode.name
+                              << std::setw(11) << goal_set.first << std::right << std::setw(4) << k << std::fixed << std::setprecision(1)
+                              << std::setw(15) << sequential_ms << std::setw(11) << batch_ms
+                              << std::setw(14) << k / (sequential_ms / 1000.0) << std::setw(16) << k / (batch_ms / 1000.0)
+                              << std::setprecision(2) << std::setw(9) << sequential_ms / batch_ms
+                              << std::setw(7) << (match ? "yes" : "NO") << std::endl;
+                    std::cout.unsetf(std::ios::fixed);
+                    std::cout << std::setprecision(6);
                 }
-                
-                std::cout << "\nOptimal path completed!" << std::endl;
             }
         }
-        
-        return duration.count() / 1000.0; // Return time in milliseconds
     }
-};
+}
 
-std::string get_system_info() {
-    std::stringstream info;
-    
-    // Get OS info
-    #ifdef __APPLE__
-        info << "OS: macOS ";
-        std::system("sw_vers -productVersion > /tmp/macos_version.txt 2>/dev/null");
-        std::ifstream version_file("/tmp/macos_version.txt");
-        std::string version;
-        if (std::getline(version_file, version)) {
-            info << version;
-        }
-        version_file.close();
-        std::system("rm -f /tmp/macos_version.txt");
-        info << "\n";
-    #elif __linux__
-        info << "OS: Linux ";
-        std::system("uname -r > /tmp/linux_version.txt 2>/dev/null");
-        std::ifstream version_file("/tmp/linux_version.txt");
-        std::string version;
-        if (std::getline(version_file, version)) {
-            info << version;
-        }
-        version_file.close();
-        std::system("rm -f /tmp/linux_version.txt");
-        info << "\n";
-    #else
-        info << "OS: Unknown\n";
-    #endif
-    
-    // Get CPU info
-    #ifdef __APPLE__
-        info << "CPU: ";
-        std::system("sysctl -n machdep.cpu.brand_string > /tmp/cpu_info.txt 2>/dev/null");
-        std::ifstream cpu_file("/tmp/cpu_info.txt");
-        std::string cpu;
-        if (std::getline(cpu_file, cpu)) {
-            info << cpu;
-        }
-        cpu_file.close();
-        std::system("rm -f /tmp/cpu_info.txt");
-        info << "\n";
-    #elif __linux__
-        info << "CPU: ";
-        std::system("grep 'model name' /proc/cpuinfo | head -1 | cut -d':' -f2 | sed 's/^ *//' > /tmp/cpu_info.txt 2>/dev/null");
-        std::ifstream cpu_file("/tmp/cpu_info.txt");
-        std::string cpu;
-        if (std::getline(cpu_file, cpu)) {
-            info << cpu;
-        }
-        cpu_file.close();
-        std::system("rm -f /tmp/cpu_info.txt");
-        info << "\n";
-    #else
-        info << "CPU: Unknown\n";
-    #endif
-    
-    // Get memory info
-    #ifdef __APPLE__
-        info << "Memory: ";
-        std::system("sysctl -n hw.memsize | awk '{print $1/1024/1024/1024 \" GB\"}' > /tmp/mem_info.txt 2>/dev/null");
-        std::ifstream mem_file("/tmp/mem_info.txt");
-        std::string mem;
-        if (std::getline(mem_file, mem)) {
-            info << mem;
-        }
-        mem_file.close();
-        std::system("rm -f /tmp/mem_info.txt");
-        info << "\n";
-    #elif __linux__
-        info << "Memory: ";
-        std::system("grep MemTotal /proc/meminfo | awk '{print $2/1024/1024 \" GB\"}' > /tmp/mem_info.txt 2>/dev/null");
-        std::ifstream mem_file("/tmp/mem_info.txt");
-        std::string mem;
-        if (std::getline(mem_file, mem)) {
-            info << mem;
-        }
-        mem_file.close();
-        std::system("rm -f /tmp/mem_info.txt");
-        info << "\n";
-    #else
-        info << "Memory: Unknown\n";
-    #endif
-    
-    return info.str();
+// planPath on the default pillars grid from 32x32 upwards in steps of sqrt(2) in side length.
+// The planner keeps an int grid and an int distance per cell.
+void run_scaling(const BenchmarkOptions& options) {
+    SweepCase sweep = {
+        "WaveFront",
+        [](int size) { WaveFrontPlanner planner(size, size); return planner.planPath(1, 1, size - 2, size - 2, false); },
+        [](int size) { return static_cast<double>(size) * size; },
+        [](int size) { return 2.0 * sizeof(int) * size * size; }
+    };
+    std::vector<SweepPoint> points = run_sweep(sweep, geometric_sizes(32, options.sweep_max, std::sqrt(2.0)), options.repeats);
+    print_sweep("Grid", points, analyze_sweep(points));
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 2;
+    }
+    
     std::cout << "WaveFront Planner Benchmark" << std::endl;
     std::cout << "===========================" << std::endl;
     
     // Small grid for visualization
-    std::cout << "\n1. Visual demonstration (30x15 grid):" << std::endl;
-    WaveFrontPlanner small_planner(30, 15);
-    double small_time = small_planner.planPath(1, 1, 28, 13, true);
-    std::cout << "Time: " << small_time << " ms" << std::endl;
-    
-    std::cout << "\nPress Enter to continue to benchmark...";
-    std::cin.get();
+    double small_time = -1.0;
+    if (options.wants("demo")) {
+        std::cout << "\n1. Visual demonstration (30x15 grid):" << std::endl;
+        WaveFrontPlanner small_planner(30, 15);
+        small_time = small_planner.planPath(1, 1, 28, 13, true);
+        std::cout << "Time: " << small_time << " ms" << std::endl;
+        
+        std::cout << "\nPress Enter to continue to benchmark...";
+        std::cin.get();
+    }
     
     // Large grid for benchmarking
-    std::cout << "\n2. Performance benchmark:" << std::endl;
     std::vector<int> sizes = {50, 100, 200, 400};
     std::vector<double> benchmark_times;
+    if (options.wants("sizes")) {
+        std::cout << "\n2. Performance benchmark:" << std::endl;
+        for (int size : sizes) {
+            std::cout << "Grid size: " << size << "x" << size << " - ";
+            std::cout.flush();
+            
+            WaveFrontPlanner planner(size, size);
+            double time = planner.planPath(1, 1, size-2, size-2, false);
+            benchmark_times.push_back(time);
+            
+            std::cout << "Time: " << time << " ms" << std::endl;
+        }
+    }
     
-    for (int size : sizes) {
-        std::cout << "Grid size: " << size << "x" << size << " - ";
-        std::cout.flush();
-        
-        WaveFrontPlanner planner(size, size);
-        double time = planner.planPath(1, 1, size-2, size-2, false);
-        benchmark_times.push_back(time);
-        
-        std::cout << "Time: " << time << " ms" << std::endl;
+    if (options.wants("maps")) {
+        std::cout << "\n3. Map classes:" << std::endl;
+        run_map_classes(options);
+    }
+    
+    if (options.wants("inflation")) {
+        std::cout << "\n4. Obstacle inflation (Euclidean distance transform vs disc stamping):" << std::endl;
+        run_inflation(options);
+    }
+    
+    if (options.wants("voxels")) {
+        std::cout << "\n5. 3D voxel planner (Morton vs linear layout):" << std::endl;
+        run_voxels(options);
+    }
+    
+    if (options.wants("hpa")) {
+        std::cout << "\n6. Hierarchical pathfinding (HPA*) vs full-grid wavefront:" << std::endl;
+        run_hierarchical(options);
+    }
+    
+    if (options.wants("fields")) {
+        std::cout << "\n7. Stored distance fields (mmap warm start vs recompute):" << std::endl;
+        run_distance_fields(options);
+    }
+    
+    if (options.wants("batch")) {
+        std::cout << "\n8. Batched multi-goal distance fields (multi-source BFS vs sequential planPath):" << std::endl;
+        run_multi_goal(options);
+    }
+    
+    if (options.wants("scaling")) {
+        std::cout << "\n9. Scaling sweep (time against grid cells, breakpoints against cache sizes):" << std::endl;
+        run_scaling(options);
     }
     
     // Output formatted results for copy-paste
@@ -301,14 +663,16 @@ int main() {
     #define CXXFLAGS "Unknown"
     #endif
     std::cout << "Compiler: g++ " << CXXFLAGS << std::endl;
+    std::cout << "Build: " << build_flavor() << std::endl;
     std::cout << "Date: " << __DATE__ << std::endl;
     
     std::cout << "\nWaveFront Planner Benchmark Results:" << std::endl;
-    std::cout << "- Grid 50x50: " << benchmark_times[0] << " ms" << std::endl;
-    std::cout << "- Grid 100x100: " << benchmark_times[1] << " ms" << std::endl;
-    std::cout << "- Grid 200x200: " << benchmark_times[2] << " ms" << std::endl;
-    std::cout << "- Grid 400x400: " << benchmark_times[3] << " ms" << std::endl;
-    std::cout << "- Visual demo time: " << small_time << " ms" << std::endl;
+    for (size_t i = 0; i < benchmark_times.size(); i++) {
+        std::cout << "- Grid " << sizes[i] << "x" << sizes[i] << ": " << benchmark_times[i] << " ms" << std::endl;
+    }
+    if (small_time >= 0.0) {
+        std::cout << "- Visual demo time: " << small_time << " ms" << std::endl;
+    }
     
     std::cout << "\nSystem information detected automatically" << std::endl;
     
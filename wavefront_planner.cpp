@@ -0,0 +1,214 @@
+#pragma once
+
+#include "cycle_timer.cpp"
+#include "kernel_dispatch.cpp"
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+class WaveFrontPlanner {
+private:
+    std::vector<std::vector<int>> grid;
+    std::vector<std::vector<int>> distance;
+    int width, height;
+    int connectivity = 4;
+    long reached_cells = 0;
+    
+    // The first four are the orthogonal neighbours
+    static constexpr int dx[8] = {-1, 1, 0, 0, -1, 1, -1, 1};
+    static constexpr int dy[8] = {0, 0, -1, 1, -1, -1, 1, 1};
+    
+    // Diagonal steps may not cut a corner between two obstacles
+    bool canStep(int x, int y, int dx, int dy) const {
+        int nx = x + dx;
+        int ny = y + dy;
+        if (nx < 0 || nx >= width || ny < 0 || ny >= height || grid[ny][nx] != 0) return false;
+        return dx == 0 || dy == 0 || (grid[y][nx] == 0 && grid[ny][x] == 0);
+    }
+    
+public:
+    WaveFrontPlanner(int w, int h) : width(w), height(h) {
+        grid.resize(height, std::vector<int>(width, 0));
+        distance.resize(height, std::vector<int>(width, -1));
+        
+        // Generate maze-like obstacles
+        for (int i = 0; i < height; i++) {
+            for (int j = 0; j < width; j++) {
+                if (i == 0 || i == height-1 || j == 0 || j == width-1) {
+                    grid[i][j] = 1; // walls at borders
+                } else if ((i % 4 == 2) && (j % 4 == 2)) {
+                    grid[i][j] = 1; // scattered obstacles
+                }
+            }
+        }
+    }
+    
+    explicit WaveFrontPlanner(const std::vector<std::vector<int>>& occupancy)
+        : grid(occupancy), width(occupancy.empty() ? 0 : static_cast<int>(occupancy[0].size())),
+          height(static_cast<int>(occupancy.size())) {
+        distance.resize(height, std::vector<int>(width, -1));
+    }
+    
+    // 4 (von Neumann) or 8 (Moore) neighbours per cell
+    void setConnectivity(int neighbours) {
+        connectivity = neighbours == 8 ? 8 : 4;
+    }
+    
+    int getConnectivity() const { return connectivity; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    const std::vector<std::vector<int>>& getGrid() const { return grid; }
+    
+    // Steps from (x, y) to the goal of the last planPath call, -1 if unreachable
+    int getDistance(int x, int y) const { return distance[y][x]; }
+    
+    // Cells labelled by the last planPath call, including the goal
+    long getReachedCells() const { return reached_cells; }
+    
+    // Cells (x, y) from start to the goal of the last planPath call, empty if unreachable
+    std::vector<std::pair<int, int>> getPath(int startX, int startY) const {
+        std::vector<std::pair<int, int>> path;
+        if (distance[startY][startX] == -1) return path;
+        int curr_x = startX, curr_y = startY;
+        path.push_back({curr_x, curr_y});
+        
+        while (distance[curr_y][curr_x] > 0) {
+            for (int i = 0; i < connectivity; i++) {
+                int nx = curr_x + dx[i];
+                int ny = curr_y + dy[i];
+                
+                if (canStep(curr_x, curr_y, dx[i], dy[i]) &&
+                    distance[ny][nx] != -1 && distance[ny][nx] < distance[curr_y][curr_x]) {
+                    curr_x = nx;
+                    curr_y = ny;
+                    path.push_back({curr_x, curr_y});
+                    break;
+                }
+            }
+        }
+        return path;
+    }
+    
+    void displayGrid() {
+        std::cout << "\033[2J\033[H"; // Clear screen and move cursor to top
+        for (int i = 0; i < height; i++) {
+            for (int j = 0; j < width; j++) {
+                if (grid[i][j] == 1) {
+                    std::cout << "█";
+                } else if (distance[i][j] == -1) {
+                    std::cout << " ";
+                } else {
+                    char c = '0' + (distance[i][j] % 10);
+                    if (distance[i][j] >= 10) c = 'A' + ((distance[i][j] - 10) % 6);
+                    std::cout << c;
+                }
+            }
+            std::cout << std::endl;
+        }
+        std::cout.flush();
+    }
+    
+    HOT_KERNEL double planPath(int startX, int startY, int goalX, int goalY, bool visualize = true) {
+        CycleTimer& timer = CycleTimer::instance();
+        uint64_t start_ticks = timer.start();
+        
+        // Reset distance grid
+        for (auto& row : distance) {
+            std::fill(row.begin(), row.end(), -1);
+        }
+        
+        std::queue<std::pair<int, int>> queue;
+        queue.push({goalY, goalX});
+        distance[goalY][goalX] = 0;
+        reached_cells = 1;
+        
+        while (!queue.empty()) {
+            auto [y, x] = queue.front();
+            queue.pop();
+            
+            if (visualize) {
+                displayGrid();
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+            
+            for (int i = 0; i < connectivity; i++) {
+                int ny = y + dy[i];
+                int nx = x + dx[i];
+                
+                if (canStep(x, y, dx[i], dy[i]) && distance[ny][nx] == -1) {
+                    distance[ny][nx] = distance[y][x] + 1;
+                    queue.push({ny, nx});
+                    reached_cells++;
+                }
+            }
+        }
+        
+        uint64_t end_ticks = timer.stop();
+        double elapsed_ms = timer.elapsed_ms(start_ticks, end_ticks);
+        
+        if (visualize) {
+            displayGrid();
+            std::cout << "\nPath planning completed!" << std::endl;
+            std::cout << "Path length from start to goal: " << distance[startY][startX] << std::endl;
+            
+            // Show optimal path from goal to start
+            if (distance[startY][startX] != -1) {
+                std::cout << "\nTracing optimal path (goal to start)..." << std::endl;
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                
+                // Build complete path first
+                std::vector<std::pair<int, int>> path = getPath(startX, startY);
+                
+                // Animate path highlighting
+                for (size_t step = 0; step < path.size(); step++) {
+                    std::cout << "\033[2J\033[H";
+                    for (int i = 0; i < height; i++) {
+                        for (int j = 0; j < width; j++) {
+                            bool on_path = false;
+                            bool current_step = false;
+                            
+                            // Check if this position is on the path and already highlighted
+                            for (size_t p = 0; p <= step; p++) {
+                                if (path[p].first == j && path[p].second == i) {
+                                    on_path = true;
+                                    if (p == step) current_step = true;
+                                    break;
+                                }
+                            }
+                            
+                            if (grid[i][j] == 1) {
+                                std::cout << "█";
+                            } else if (on_path) {
+                                if (current_step) {
+                                    std::cout << "\033[1;33m*\033[0m"; // Bright yellow for current
+                                } else {
+                                    std::cout << "\033[1;32m#\033[0m"; // Bright green for path
+                                }
+                            } else if (distance[i][j] == -1) {
+                                std::cout << " ";
+                            } else {
+                                // Dim the background numbers
+                                char c = '0' + (distance[i][j] % 10);
+                                if (distance[i][j] >= 10) c = 'A' + ((distance[i][j] - 10) % 6);
+                                std::cout << "\033[2m" << c << "\033[0m"; // Dim
+                            }
+                        }
+                        std::cout << std::endl;
+                    }
+                    std::cout << "Path step " << (step + 1) << "/" << path.size() 
+                              << " at (" << path[step].first << "," << path[step].second << ")" << std::endl;
+                    std::cout.flush();
+                    
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+                
+                std::cout << "\nOptimal path completed!" << std::endl;
+            }
+        }
+        
+        return elapsed_ms; // Return time in milliseconds
+    }
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+
+// Thread counts and row splitting shared by the renderers and the planners, and a
+// pool of threads that stay alive between calls for callers that split work many
+// times over (a batch of renders, one colouring pass per image). Without a pool the
+// helpers start their threads for the call and join them before returning.
+
+int default_thread_count() {
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : static_cast<int>(hw);
+}
+
+// threads <= 0 means every hardware thread; never more threads than work items
+int resolve_thread_count(int threads, int work_items = std::numeric_limits<int>::max()) {
+    if (threads <= 0) threads = default_thread_count();
+    return std::max(1, std::min(threads, work_items));
+}
+
+// run(threads, body) calls body(0) .. body(threads - 1), the caller being thread 0,
+// and returns when all of them have; workers are started the first time they are
+// needed and wait for the next call in between. One caller at a time.
+class WorkerPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    const std::function<void(int)>* job = nullptr;
+    int active = 0;             // threads taking part in the current call, caller included
+    int running = 0;            // workers not done with it yet
+    uint64_t generation = 0;    // calls so far
+    bool stopping = false;
+    
+    void loop(int index, uint64_t seen) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            if (index >= active) continue;
+            const std::function<void(int)>& body = *job;
+            lock.unlock();
+            body(index);
+            lock.lock();
+            if (--running == 0) finished.notify_one();
+        }
+    }
+    
+public:
+    WorkerPool() = default;
+    
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& w : workers) w.join();
+    }
+    
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    
+    void run(int threads, const std::function<void(int)>& body) {
+        threads = std::max(1, threads);
+        if (threads == 1) {
+            body(0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (static_cast<int>(workers.size()) < threads - 1) {
+                workers.emplace_back(&WorkerPool::loop, this, static_cast<int>(workers.size()) + 1, generation);
+            }
+            job = &body;
+            active = threads;
+            running = threads - 1;
+            generation++;
+        }
+        wake.notify_all();
+        body(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&] { return running == 0; });
+        job = nullptr;
+    }
+};
+
+// body(thread) on threads threads, on the pool's when there is one
+void run_threads(WorkerPool* pool, int threads, const std::function<void(int)>& body) {
+    if (pool) {
+        pool->run(threads, body);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) workers.emplace_back(body, t);
+    body(0);
+    for (auto& w : workers) w.join();
+}
+
+// Rows handed out one at a time, for rows that differ a lot in cost (Mandelbrot): body(row)
+void parallel_rows(int rows, int threads, const std::function<void(int)>& body, WorkerPool* pool = nullptr) {
+    threads = resolve_thread_count(threads, rows);
+    std::atomic<int> next(0);
+    run_threads(pool, threads, [&](int) {
+        for (int row = next++; row < rows; row = next++) body(row);
+    });
+}
+
+// One equal block of rows per thread, for rows that cost the same:
+// body(thread, first_row, end_row)
+void split_rows(int rows, int threads, const std::function<void(int, int, int)>& body, WorkerPool* pool = nullptr) {
+    threads = resolve_thread_count(threads, rows);
+    run_threads(pool, threads, [&](int t) {
+        body(t, static_cast<int>(static_cast<long>(rows) * t / threads),
+             static_cast<int>(static_cast<long>(rows) * (t + 1) / threads));
+    });
+}